@@ -0,0 +1,2004 @@
+/**
+* SBDL: Sadegh & Borjian Directmedia Layer!
+*/
+
+#include "SBDL.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+
+namespace SBDL {
+	/**
+	* don't import this namespace
+	* this namespace used for handle underneath SDL functions for you
+	*/
+	namespace Core {
+		/**
+		* current state of SDL
+		*/
+		bool running = true;
+
+		/**
+		* SDL keyboard state array size
+		*/
+		int keystate_size = -1;
+
+		/**
+		* SDL current keyboard state
+		*/
+		const Uint8 *keystate = nullptr;
+
+		/**
+		* SDL last keyboard state
+		*/
+		Uint8 *old_keystate = nullptr;
+
+		/**
+		* SDL current event
+		*/
+		SDL_Event event;
+
+		/**
+		* SDL windows
+		*/
+		SDL_Window *window = nullptr;
+
+		/**
+		* SDL renderer
+		*/
+		SDL_Renderer *renderer = nullptr;
+
+		/**
+		* file which input is recorded in and file which input is replayed from
+		*/
+		SDL_RWops *recordFile = nullptr;
+		SDL_RWops *replayFile = nullptr;
+
+		/**
+		* keyboard state which is written to recorded file last time
+		*/
+		std::vector<Uint8> recordedKeys;
+
+		/**
+		* keyboard state of replayed frame
+		*/
+		std::vector<Uint8> replayedKeys;
+
+		/**
+		* bytes of replayed frame, a frame is applied only after all of it is read
+		*/
+		std::vector<Uint8> replayBuffer;
+
+		/**
+		* true if getTime must return time of current frame, while recording or replaying input
+		*/
+		bool frameClock = false;
+
+		/**
+		* time of current frame which getTime returns when frameClock is true
+		*/
+		Uint32 frameClockTime = 0;
+
+		/**
+		* false if delays must be skipped while replaying
+		*/
+		bool replayRealSpeed = true;
+
+		/**
+		* first bytes of recorded file
+		*/
+		const char recordMagic[8] = { 'S', 'B', 'D', 'L', 'I', 'N', 'P', '1' };
+
+		/**
+		* bits of mouse and quit state in a recorded frame
+		*/
+		enum RecordFlags {
+			RecordMouseLeft = 1,
+			RecordMouseRight = 2,
+			RecordMouseMiddle = 4,
+			RecordQuit = 8
+		};
+
+		/**
+		* write input of current frame to recorded file
+		* frame is written as: time, number of changed keys, (scancode, state) of each changed key,
+		mouse position, mouse flags, mouse state, clicks and button
+		*/
+		void recordFrame() {
+			if (recordFile == nullptr)
+				return;
+			std::vector<Uint16> changed;
+			for (int i = 0; i < keystate_size && i < int(recordedKeys.size()); i++)
+				if (recordedKeys[i] != keystate[i]) {
+					changed.push_back(Uint16(i));
+					recordedKeys[i] = keystate[i];
+				}
+
+			frameClockTime = SDL_GetTicks();
+			SDL_WriteLE32(recordFile, frameClockTime);
+			SDL_WriteLE16(recordFile, Uint16(changed.size()));
+			for (size_t i = 0; i < changed.size(); i++) {
+				SDL_WriteLE16(recordFile, changed[i]);
+				SDL_WriteU8(recordFile, recordedKeys[changed[i]]);
+			}
+			SDL_WriteLE32(recordFile, Uint32(Mouse.x));
+			SDL_WriteLE32(recordFile, Uint32(Mouse.y));
+			Uint8 flags = (Mouse.left ? RecordMouseLeft : 0) | (Mouse.right ? RecordMouseRight : 0) |
+				(Mouse.middle ? RecordMouseMiddle : 0) | (running ? 0 : RecordQuit);
+			SDL_WriteU8(recordFile, flags);
+			SDL_WriteU8(recordFile, Mouse.state);
+			SDL_WriteU8(recordFile, Mouse.clicks);
+			SDL_WriteU8(recordFile, Mouse.button);
+		}
+
+		/**
+		* close replayed file and stop program
+		*/
+		void finishReplay() {
+			SDL_RWclose(replayFile);
+			replayFile = nullptr;
+			frameClock = recordFile != nullptr;
+			replayRealSpeed = true;
+			running = false;
+		}
+
+		/**
+		* little endian values of replayed frame
+		*/
+		Uint16 readLE16(const Uint8 *bytes) {
+			return Uint16(bytes[0] | bytes[1] << 8);
+		}
+
+		Uint32 readLE32(const Uint8 *bytes) {
+			return Uint32(bytes[0]) | Uint32(bytes[1]) << 8 | Uint32(bytes[2]) << 16 | Uint32(bytes[3]) << 24;
+		}
+
+		/**
+		* read input of next frame from replayed file instead of keyboard and mouse
+		* a truncated frame finishes replay without applying any of it
+		*/
+		void replayFrame() {
+			for (int i = 0; i < keystate_size; i++)
+				old_keystate[i] = keystate[i];
+
+			// time and number of changed keys, then 3 bytes per key, then 12 bytes of mouse
+			Uint8 header[6];
+			if (SDL_RWread(replayFile, header, sizeof(header), 1) != 1) {
+				finishReplay();
+				return;
+			}
+			int count = readLE16(header + 4);
+			replayBuffer.resize(count * 3 + 12);
+			if (SDL_RWread(replayFile, replayBuffer.data(), replayBuffer.size(), 1) != 1) {
+				finishReplay();
+				return;
+			}
+
+			frameClockTime = readLE32(header);
+			const Uint8 *bytes = replayBuffer.data();
+			for (int i = 0; i < count; i++, bytes += 3) {
+				Uint16 scancode = readLE16(bytes);
+				if (scancode < replayedKeys.size())
+					replayedKeys[scancode] = bytes[2];
+			}
+			Mouse.x = int(readLE32(bytes));
+			Mouse.y = int(readLE32(bytes + 4));
+			Uint8 flags = bytes[8];
+			Mouse.left = (flags & RecordMouseLeft) != 0;
+			Mouse.right = (flags & RecordMouseRight) != 0;
+			Mouse.middle = (flags & RecordMouseMiddle) != 0;
+			Mouse.state = bytes[9];
+			Mouse.clicks = bytes[10];
+			Mouse.button = bytes[11];
+			if (flags & RecordQuit)
+				running = false;
+
+			// ignore real input, but let the window be closed
+			SDL_PumpEvents();
+			while (SDL_PollEvent(&event))
+				if (event.type == SDL_QUIT)
+					running = false;
+		}
+
+		/**
+		* renderer configuration used by InitEngine
+		*/
+		RenderSettings renderSettings;
+
+		/**
+		* timing of presented frames
+		*/
+		RenderStats renderStats = {};
+
+		/**
+		* true if swap interval of OpenGL context is set to adaptive vsync
+		*/
+		bool adaptivePresent = false;
+
+		/**
+		* performance counter of last present and next frame deadline
+		*/
+		Uint64 lastPresent = 0;
+		Uint64 nextFrame = 0;
+
+		/**
+		* milliseconds which each frame may take before it counts as missed, 0 if unknown
+		*/
+		double frameDeadline = 0;
+
+		/**
+		* convert a difference of performance counters to milliseconds
+		*/
+		double counterToMilliseconds(Uint64 difference) {
+			return double(difference) * 1000.0 / double(SDL_GetPerformanceFrequency());
+		}
+
+		/**
+		* a buffer for one captured frame
+		*/
+		struct CaptureBuffer {
+			std::vector<Uint8> pixels;
+			Uint32 frame = 0;
+			bool free = true;
+		};
+
+		/**
+		* frame capture configuration
+		*/
+		CaptureSettings captureSettings;
+
+		/**
+		* statistics of frame capture, guarded by captureMutex
+		*/
+		CaptureStats captureStats = {};
+
+		/**
+		* true while frames are captured
+		*/
+		bool capturing = false;
+
+		/**
+		* size of captured frames
+		*/
+		int captureWidth = 0;
+		int captureHeight = 0;
+
+		/**
+		* number of frames shown since start of capture
+		*/
+		Uint32 captureFrameCounter = 0;
+
+		/**
+		* capture buffers, encoding queue and workers, guarded by captureMutex
+		*/
+		std::vector<CaptureBuffer> captureBuffers;
+		std::vector<int> captureQueue;
+		std::vector<SDL_Thread *> captureWorkers;
+		SDL_mutex *captureMutex = nullptr;
+		SDL_cond *captureCondition = nullptr;
+		bool captureStopping = false;
+
+		/**
+		* video file of Y4mCapture, only used by one worker
+		*/
+		SDL_RWops *captureVideo = nullptr;
+
+		/**
+		* YUV planes of a video frame, only used by one worker
+		*/
+		std::vector<Uint8> captureYuv;
+
+		/**
+		* write a frame as PNG file, return false if it is not written
+		*/
+		bool encodePng(const CaptureBuffer &buffer) {
+			SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<Uint8 *>(buffer.pixels.data()),
+				captureWidth, captureHeight, 32, captureWidth * 4, SDL_PIXELFORMAT_ARGB8888);
+			if (surface == nullptr)
+				return false;
+			char number[16];
+			SDL_snprintf(number, sizeof(number), "%06u", buffer.frame);
+			bool written = IMG_SavePNG(surface, (captureSettings.path + number + ".png").c_str()) == 0;
+			SDL_FreeSurface(surface);
+			return written;
+		}
+
+		/**
+		* convert a frame to YUV 4:2:0 and append it to video file, return false if it is not written
+		*/
+		bool encodeY4m(const CaptureBuffer &buffer) {
+			const int width = captureWidth, height = captureHeight;
+			const int chromaWidth = width / 2, chromaHeight = height / 2;
+			captureYuv.resize(width * height + 2 * chromaWidth * chromaHeight);
+			Uint8 *yPlane = captureYuv.data();
+			Uint8 *uPlane = yPlane + width * height;
+			Uint8 *vPlane = uPlane + chromaWidth * chromaHeight;
+			const Uint32 *pixels = reinterpret_cast<const Uint32 *>(buffer.pixels.data());
+
+			// full range BT.601, chroma is average of each 2x2 block
+			for (int y = 0; y < height; y++)
+				for (int x = 0; x < width; x++) {
+					Uint32 p = pixels[y * width + x];
+					int r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+					yPlane[y * width + x] = Uint8((77 * r + 150 * g + 29 * b) >> 8);
+				}
+			for (int y = 0; y < chromaHeight; y++)
+				for (int x = 0; x < chromaWidth; x++) {
+					int r = 0, g = 0, b = 0;
+					for (int i = 0; i < 4; i++) {
+						Uint32 p = pixels[(2 * y + i / 2) * width + 2 * x + i % 2];
+						r += (p >> 16) & 0xFF;
+						g += (p >> 8) & 0xFF;
+						b += p & 0xFF;
+					}
+					uPlane[y * chromaWidth + x] = Uint8(((-43 * r - 85 * g + 128 * b) / 1024) + 128);
+					vPlane[y * chromaWidth + x] = Uint8(((128 * r - 107 * g - 21 * b) / 1024) + 128);
+				}
+
+			return SDL_RWwrite(captureVideo, "FRAME\n", 6, 1) == 1 &&
+				SDL_RWwrite(captureVideo, captureYuv.data(), captureYuv.size(), 1) == 1;
+		}
+
+		/**
+		* encode captured frames until capture stops, runs in worker threads
+		*/
+		int encodeFrames(void *) {
+			SDL_LockMutex(captureMutex);
+			while (true) {
+				while (captureQueue.empty() && !captureStopping)
+					SDL_CondWait(captureCondition, captureMutex);
+				if (captureQueue.empty())
+					break;
+				int index = captureQueue.front();
+				captureQueue.erase(captureQueue.begin());
+				SDL_UnlockMutex(captureMutex);
+
+				Uint64 start = SDL_GetPerformanceCounter();
+				bool written;
+				if (captureSettings.format == PngCapture)
+					written = encodePng(captureBuffers[index]);
+				else
+					written = encodeY4m(captureBuffers[index]);
+				double time = counterToMilliseconds(SDL_GetPerformanceCounter() - start);
+
+				SDL_LockMutex(captureMutex);
+				captureBuffers[index].free = true;
+				if (written)
+					captureStats.encoded++;
+				else
+					captureStats.failed++;
+				captureStats.encodeTime = captureStats.encoded + captureStats.failed == 1 ? time :
+					captureStats.encodeTime * 0.95 + time * 0.05;
+			}
+			SDL_UnlockMutex(captureMutex);
+			return 0;
+		}
+
+		/**
+		* copy current frame to a free capture buffer and send it to workers
+		*/
+		void captureFrame() {
+			if (!capturing || captureFrameCounter++ % captureSettings.frameInterval != 0)
+				return;
+
+			int index = -1;
+			SDL_LockMutex(captureMutex);
+			for (int i = 0; i < int(captureBuffers.size()) && index == -1; i++)
+				if (captureBuffers[i].free)
+					index = i;
+			if (index == -1)
+				captureStats.dropped++;
+			SDL_UnlockMutex(captureMutex);
+			if (index == -1)
+				return;
+
+			// only this thread takes free buffers and workers only touch queued ones, so it is safe without lock
+			CaptureBuffer &buffer = captureBuffers[index];
+			SDL_Rect area = { 0, 0, captureWidth, captureHeight };
+			Uint64 start = SDL_GetPerformanceCounter();
+			if (SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, buffer.pixels.data(),
+				captureWidth * 4) != 0)
+				return;
+			double time = counterToMilliseconds(SDL_GetPerformanceCounter() - start);
+
+			SDL_LockMutex(captureMutex);
+			buffer.free = false;
+			buffer.frame = captureStats.captured++;
+			captureStats.readTime = buffer.frame == 0 ? time : captureStats.readTime * 0.95 + time * 0.05;
+			captureQueue.push_back(index);
+			SDL_CondSignal(captureCondition);
+			SDL_UnlockMutex(captureMutex);
+		}
+
+		/**
+		* audio configuration used by InitEngine
+		*/
+		AudioSettings audioSettings;
+
+		/**
+		* playing rule of a sound
+		*/
+		struct SoundRule {
+			int priority = 0;
+			int maxInstances = 0;
+		};
+
+		/**
+		* rules which are set with setSoundPriority
+		*/
+		std::unordered_map<const Sound *, SoundRule> soundRules;
+
+		/**
+		* state of each mixer channel
+		*/
+		struct Voice {
+			const Sound *sound = nullptr;
+			int priority = 0;
+			Uint32 order = 0;
+		};
+
+		/**
+		* voices which are allocated by InitEngine
+		*/
+		std::vector<Voice> voices;
+
+		/**
+		* counter for finding oldest voice
+		*/
+		Uint32 voiceOrder = 0;
+
+		/**
+		* statistics of voice stealing
+		*/
+		int stolenVoices = 0;
+		int droppedSounds = 0;
+
+		/**
+		* measured by audio thread
+		*/
+		std::atomic<int> audioCallbackBytes(0);
+		std::atomic<Uint64> audioCallbackTime(0);
+		std::atomic<double> audioCallbackPeriod(0);
+
+		/**
+		* measure size and period of audio callbacks, called by SDL_mixer in audio thread
+		*/
+		void measureAudioCallback(void *, Uint8 *, int length) {
+			Uint64 now = SDL_GetPerformanceCounter();
+			Uint64 last = audioCallbackTime.exchange(now);
+			if (last != 0) {
+				double period = double(now - last) * 1000.0 / double(SDL_GetPerformanceFrequency());
+				double average = audioCallbackPeriod.load();
+				audioCallbackPeriod.store(average == 0 ? period : average * 0.9 + period * 0.1);
+			}
+			audioCallbackBytes.store(length);
+		}
+
+		/**
+		* information about a resource which is not freed yet
+		*/
+		struct TrackedResource {
+			ResourceType type;
+			size_t bytes;
+			std::string tag;
+		};
+
+		/**
+		* all resources which are not freed yet
+		*/
+		std::unordered_map<const void *, TrackedResource> trackedResources;
+
+		/**
+		* usage of each kind of resource
+		*/
+		ResourceStats resourceStats[ResourceTypeCount] = {};
+
+		/**
+		* resources created and freed in current frame
+		*/
+		int createdThisFrame[ResourceTypeCount] = {};
+		int destroyedThisFrame[ResourceTypeCount] = {};
+
+		/**
+		* tag which is attached to new resources
+		*/
+		std::string resourceTag;
+
+		/**
+		* remember a new resource
+		*/
+		void trackResource(const void *resource, ResourceType type, size_t bytes) {
+			if (resource == nullptr)
+				return;
+			TrackedResource &tracked = trackedResources[resource];
+			tracked.type = type;
+			tracked.bytes = bytes;
+			tracked.tag = resourceTag;
+			resourceStats[type].live++;
+			resourceStats[type].bytes += bytes;
+			resourceStats[type].totalCreated++;
+			createdThisFrame[type]++;
+		}
+
+		/**
+		* forget a freed resource, resources which are not tracked are ignored
+		*/
+		void untrackResource(const void *resource) {
+			std::unordered_map<const void *, TrackedResource>::iterator found = trackedResources.find(resource);
+			if (found == trackedResources.end())
+				return;
+			ResourceType type = found->second.type;
+			resourceStats[type].live--;
+			resourceStats[type].bytes -= found->second.bytes;
+			resourceStats[type].totalDestroyed++;
+			destroyedThisFrame[type]++;
+			trackedResources.erase(found);
+		}
+
+		/**
+		* log resources which are not freed at exit, defined after dumpResources
+		*/
+		void reportLeakedResources();
+
+		/**
+		* start counting resources of a new frame
+		*/
+		void finishResourceFrame() {
+			for (int i = 0; i < ResourceTypeCount; i++) {
+				resourceStats[i].createdLastFrame = createdThisFrame[i];
+				resourceStats[i].destroyedLastFrame = destroyedThisFrame[i];
+				createdThisFrame[i] = destroyedThisFrame[i] = 0;
+			}
+		}
+
+		/**
+		* all sounds which are loaded with loadCompressedSound
+		*/
+		std::vector<CompressedSound *> compressedSounds;
+
+		/**
+		* maximum bytes of decoded compressed sounds which are kept for playing again
+		*/
+		size_t soundCacheLimit = 8 * 1024 * 1024;
+
+		/**
+		* current bytes of decoded compressed sounds
+		*/
+		size_t soundCacheBytes = 0;
+
+		/**
+		* statistics of sound cache
+		*/
+		int soundCacheHits = 0;
+		int soundCacheMisses = 0;
+
+		/**
+		* counter for finding least recently used decoded sound
+		*/
+		Uint32 soundUseOrder = 0;
+
+		/**
+		* sound decoder thread and its queues, all guarded by decoderMutex
+		*/
+		SDL_Thread *decoderThread = nullptr;
+		SDL_mutex *decoderMutex = nullptr;
+		SDL_cond *decoderCondition = nullptr;
+		std::vector<CompressedSound *> decodeQueue;
+		CompressedSound *decodingSound = nullptr;
+		std::vector<std::pair<CompressedSound *, Sound *> > decodedQueue;
+		bool decoderStopping = false;
+
+		/**
+		* decode sounds of decodeQueue one by one, runs in decoder thread
+		*/
+		int decodeSounds(void *) {
+			SDL_LockMutex(decoderMutex);
+			while (true) {
+				while (decodeQueue.empty() && !decoderStopping)
+					SDL_CondWait(decoderCondition, decoderMutex);
+				if (decoderStopping)
+					break;
+				decodingSound = decodeQueue.front();
+				decodeQueue.erase(decodeQueue.begin());
+				const std::vector<Uint8> &data = decodingSound->data;
+				SDL_UnlockMutex(decoderMutex);
+
+				Sound *decoded = Mix_LoadWAV_RW(SDL_RWFromConstMem(data.data(), int(data.size())), 1);
+
+				SDL_LockMutex(decoderMutex);
+				decodedQueue.push_back(std::make_pair(decodingSound, decoded));
+				decodingSound = nullptr;
+				SDL_CondBroadcast(decoderCondition);
+			}
+			SDL_UnlockMutex(decoderMutex);
+			return 0;
+		}
+
+		/**
+		* stop decoder thread at exit, queued sounds are dropped and finished ones are freed
+		*/
+		void stopDecoder() {
+			if (decoderThread == nullptr)
+				return;
+
+			SDL_LockMutex(decoderMutex);
+			decoderStopping = true;
+			SDL_CondBroadcast(decoderCondition);
+			SDL_UnlockMutex(decoderMutex);
+			SDL_WaitThread(decoderThread, nullptr);
+			decoderThread = nullptr;
+
+			for (size_t i = 0; i < decodeQueue.size(); i++) {
+				decodeQueue[i]->decoding = false;
+				decodeQueue[i]->pendingPlays.clear();
+			}
+			decodeQueue.clear();
+			for (size_t i = 0; i < decodedQueue.size(); i++) {
+				decodedQueue[i].first->decoding = false;
+				decodedQueue[i].first->pendingPlays.clear();
+				if (decodedQueue[i].second)
+					Mix_FreeChunk(decodedQueue[i].second);
+			}
+			decodedQueue.clear();
+
+			SDL_DestroyCond(decoderCondition);
+			SDL_DestroyMutex(decoderMutex);
+			decoderCondition = nullptr;
+			decoderMutex = nullptr;
+			decoderStopping = false;
+		}
+
+		/**
+		* send a sound to decoder thread, start the thread if it is not started yet
+		*/
+		void requestDecode(CompressedSound *sound) {
+			if (decoderThread == nullptr) {
+				decoderMutex = SDL_CreateMutex();
+				decoderCondition = SDL_CreateCond();
+				decoderThread = SDL_CreateThread(decodeSounds, "SBDL sound decoder", nullptr);
+
+				static bool exitHandlerRegistered = false;
+				if (!exitHandlerRegistered) {
+					atexit(stopDecoder);
+					exitHandlerRegistered = true;
+				}
+			}
+			sound->decoding = true;
+			SDL_LockMutex(decoderMutex);
+			decodeQueue.push_back(sound);
+			SDL_CondBroadcast(decoderCondition);
+			SDL_UnlockMutex(decoderMutex);
+		}
+
+		/**
+		* play sounds which decoder thread finished and keep cache in its limit
+		* defined after playSound
+		*/
+		void playDecodedSounds();
+
+		/**
+		 * create texture with given features
+		 * @param path path of texture
+		 * @param changeColor true if given color must be replaced with transparent color
+		 * @param r red color
+		 * @param g green color
+		 * @param b blue color
+		 * @param alpha transparency level
+		 * @return texture which is created
+		 */
+		Texture loadTextureUnderneath(const std::string &path, bool changeColor, Uint8 r, Uint8 g, Uint8 b,
+			Uint8 alpha = 255) {
+			// Check existence of image
+			SDL_Surface *pic = IMG_Load(path.c_str());
+			if (pic == nullptr) {
+				const std::string message = "Missing Image file: " + path;
+				SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load image error", message.c_str(), nullptr);
+				exit(1);
+			}
+
+			if (changeColor)
+				SDL_SetColorKey(pic, SDL_TRUE, SDL_MapRGB(pic->format, r, g, b));
+			if (alpha != 255)
+				SDL_SetSurfaceAlphaMod(pic, alpha);
+
+			Texture newTexture;
+			newTexture.underneathTexture = SDL_CreateTextureFromSurface(renderer, pic);
+			newTexture.width = pic->w;
+			newTexture.height = pic->h;
+
+			SDL_SetTextureBlendMode(newTexture.underneathTexture, SDL_BLENDMODE_BLEND);
+			SDL_FreeSurface(pic);
+			trackResource(newTexture.underneathTexture, TextureResource, size_t(newTexture.width) * newTexture.height * 4);
+
+			return newTexture;
+		}
+	}
+
+	struct Mouse Mouse;
+
+	void setAudioSettings(const AudioSettings &settings) {
+		Core::audioSettings = settings;
+	}
+
+	AudioInfo getAudioInfo() {
+		AudioInfo info = {};
+		Mix_QuerySpec(&info.frequency, &info.format, &info.channels);
+		int frameSize = SDL_AUDIO_BITSIZE(info.format) / 8 * info.channels;
+		if (frameSize > 0 && info.frequency > 0) {
+			info.callbackSamples = Core::audioCallbackBytes.load() / frameSize;
+			info.bufferLatency = info.callbackSamples * 1000.0 / info.frequency;
+		}
+		info.callbackPeriod = Core::audioCallbackPeriod.load();
+		info.stolenVoices = Core::stolenVoices;
+		info.droppedSounds = Core::droppedSounds;
+		return info;
+	}
+
+	void InitEngine(const std::string &windowsTitle, int windowsWidth, int windowsHeight,
+		Uint8 r, Uint8 g, Uint8 b) {
+		atexit(SDL_Quit); // set a SDL_Quit as exit function
+		atexit(Core::reportLeakedResources); // runs before SDL_Quit
+		if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL initialization", "SBDL initialize video engine error",
+				nullptr);
+			exit(1);
+		}
+
+		const RenderSettings &render = Core::renderSettings;
+		Uint32 rendererFlags = 0;
+		if (render.backend == AcceleratedRenderer)
+			rendererFlags |= SDL_RENDERER_ACCELERATED;
+		else if (render.backend == SoftwareRenderer)
+			rendererFlags |= SDL_RENDERER_SOFTWARE;
+		if (render.presentMode != ImmediatePresent)
+			rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+		if (!render.driver.empty())
+			SDL_SetHint(SDL_HINT_RENDER_DRIVER, render.driver.c_str());
+
+		Core::window = SDL_CreateWindow(windowsTitle.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+			windowsWidth, windowsHeight, render.hiddenWindow ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
+		Core::renderer = SDL_CreateRenderer(Core::window, -1, rendererFlags);
+		if (Core::renderer == nullptr) // requested renderer is not available, use any renderer
+			Core::renderer = SDL_CreateRenderer(Core::window, -1, 0);
+		if (Core::window == nullptr || Core::renderer == nullptr) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL initialization", "SBDL create renderer error",
+				nullptr);
+			exit(1);
+		}
+		// SDL renderer accepts only on or off for vsync, but OpenGL drivers can ask their context for adaptive
+		// one, if it fails plain vsync from renderer flags is kept
+		SDL_RendererInfo rendererInfo;
+		if (render.presentMode == AdaptivePresent && SDL_GetRendererInfo(Core::renderer, &rendererInfo) == 0 &&
+			SDL_strncmp(rendererInfo.name, "opengl", 6) == 0)
+			Core::adaptivePresent = SDL_GL_SetSwapInterval(-1) == 0;
+
+		// find frame deadline for counting missed frames
+		SDL_DisplayMode display;
+		if (render.targetFps > 0)
+			Core::frameDeadline = 1000.0 / render.targetFps;
+		else if (render.presentMode != ImmediatePresent &&
+			SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(Core::window), &display) == 0 &&
+			display.refresh_rate > 0)
+			Core::frameDeadline = 1000.0 / display.refresh_rate;
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");  // make the scaled rendering look smoother
+		SDL_RenderSetLogicalSize(Core::renderer, windowsWidth, windowsHeight);
+		SDL_SetRenderDrawColor(Core::renderer, r, g, b, 255);
+		SDL_SetRenderDrawBlendMode(Core::renderer, SDL_BLENDMODE_BLEND);
+
+		SDL_SetWindowTitle(Core::window, windowsTitle.c_str());
+		// inilialize SDL_mixer, exit if fail
+		if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL initialization", "SBDL initialize audio engine error",
+				nullptr);
+			exit(1);
+		}
+
+		// setup audio mode
+		const AudioSettings &audio = Core::audioSettings;
+		if (Mix_OpenAudio(audio.frequency, audio.format, audio.channels, audio.chunkSize) < 0) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL initialization", "SBDL initialize audio engine error",
+				nullptr);
+			exit(1);
+		}
+		Mix_AllocateChannels(audio.voices);
+		Core::voices.assign(audio.voices, Core::Voice());
+		Mix_SetPostMix(Core::measureAudioCallback, nullptr);
+		// setup text system
+		TTF_Init();
+	}
+
+	bool startRecording(const std::string &path) {
+		stopRecording();
+		Core::recordFile = SDL_RWFromFile(path.c_str(), "wb");
+		if (Core::recordFile == nullptr)
+			return false;
+		SDL_RWwrite(Core::recordFile, Core::recordMagic, sizeof(Core::recordMagic), 1);
+		SDL_WriteLE16(Core::recordFile, SDL_NUM_SCANCODES);
+		Core::recordedKeys.assign(SDL_NUM_SCANCODES, 0);
+		Core::frameClock = true;
+		Core::frameClockTime = SDL_GetTicks();
+		return true;
+	}
+
+	void stopRecording() {
+		if (Core::recordFile == nullptr)
+			return;
+		SDL_RWclose(Core::recordFile);
+		Core::recordFile = nullptr;
+		Core::frameClock = Core::replayFile != nullptr;
+	}
+
+	bool startReplay(const std::string &path, bool realSpeed) {
+		SDL_RWops *file = SDL_RWFromFile(path.c_str(), "rb");
+		if (file == nullptr)
+			return false;
+		char magic[sizeof(Core::recordMagic)];
+		if (SDL_RWread(file, magic, sizeof(magic), 1) != 1 ||
+			!std::equal(magic, magic + sizeof(magic), Core::recordMagic)) {
+			SDL_RWclose(file);
+			return false;
+		}
+		int keyCount = SDL_ReadLE16(file);
+
+		if (Core::replayFile)
+			SDL_RWclose(Core::replayFile);
+		Core::replayFile = file;
+		Core::frameClock = true;
+		Core::replayRealSpeed = realSpeed;
+		// replayed keyboard state starts with no key pressed
+		if (Core::keystate_size == -1) {
+			Core::keystate_size = keyCount > SDL_NUM_SCANCODES ? keyCount : SDL_NUM_SCANCODES;
+			Core::old_keystate = new Uint8[Core::keystate_size];
+		}
+		Core::replayedKeys.assign(keyCount > Core::keystate_size ? keyCount : Core::keystate_size, 0);
+		for (int i = 0; i < Core::keystate_size; i++)
+			Core::old_keystate[i] = 0;
+		Core::keystate = Core::replayedKeys.data();
+		return true;
+	}
+
+	bool isReplaying() {
+		return Core::replayFile != nullptr;
+	}
+
+	void updateEvents() {
+		if (Core::replayFile) {
+			Core::replayFrame();
+			Core::playDecodedSounds();
+			return;
+		}
+
+		// update keyboard state
+		if (Core::keystate_size == -1) {
+			Core::keystate = SDL_GetKeyboardState(&Core::keystate_size);
+			Core::old_keystate = new Uint8[Core::keystate_size];
+			for (int i = 0; i < Core::keystate_size; i++)
+				Core::old_keystate[i] = 0;
+		}
+		else {
+			for (int i = 0; i < Core::keystate_size; i++)
+				Core::old_keystate[i] = Core::keystate[i];
+			Core::keystate = SDL_GetKeyboardState(&Core::keystate_size);
+		}
+		SDL_PumpEvents();
+		Core::playDecodedSounds();
+
+		// close app if ESCAPE pressed
+		if (keyPressed(SDL_SCANCODE_ESCAPE)) {
+			Core::running = false;
+		}
+
+		// reset event handler state for check it again
+		Core::event = {};
+
+		// returns true if there is an event in the queue, but will not remove it
+		if (!SDL_PollEvent(nullptr)) {
+			Mouse.left = Mouse.middle = Mouse.right = false;
+			Mouse.button = 0;
+			Core::recordFrame();
+			return;
+		}
+		while (SDL_PollEvent(&Core::event)) { // loop until there is a new event for handling
+			if (Core::event.type == SDL_MOUSEBUTTONDOWN || Core::event.type == SDL_MOUSEBUTTONUP) {
+				// update state of Mouse structure if it was changed
+				switch (Core::event.button.button) {
+				case 1:
+					Mouse.left = true;
+					Mouse.right = Mouse.middle = false;
+					break;
+				case 2:
+					Mouse.middle = true;
+					Mouse.right = Mouse.left = false;
+					break;
+				case 3:
+					Mouse.right = true;
+					Mouse.left = Mouse.middle = false;
+					break;
+				default:
+					Mouse.left = Mouse.middle = Mouse.right = false;
+				}
+
+				Mouse.state = Core::event.button.state;
+				Mouse.button = Core::event.button.button;
+				Mouse.clicks = Core::event.button.clicks;
+			}
+			// update position of mouse if it was changed
+			if (Core::event.type == SDL_MOUSEMOTION) {
+				Mouse.x = Core::event.motion.x;
+				Mouse.y = Core::event.motion.y;
+			}
+			if (Core::event.type == SDL_QUIT) {
+				Core::running = false;
+			}
+		}
+		Core::recordFrame();
+	}
+
+	void clearRenderScreen() {
+		SDL_RenderClear(Core::renderer);
+	}
+
+	void updateRenderScreen() {
+		Core::captureFrame();
+		Uint64 start = SDL_GetPerformanceCounter();
+		SDL_RenderPresent(Core::renderer);
+		Uint64 end = SDL_GetPerformanceCounter();
+		Core::finishResourceFrame();
+
+		RenderStats &stats = Core::renderStats;
+		stats.presentTime = Core::counterToMilliseconds(end - start);
+		stats.averagePresentTime = stats.frames == 0 ? stats.presentTime :
+			stats.averagePresentTime * 0.95 + stats.presentTime * 0.05;
+		if (stats.frames > 0) {
+			double frameTime = Core::counterToMilliseconds(end - Core::lastPresent);
+			stats.frameTime = stats.frames == 1 ? frameTime : stats.frameTime * 0.95 + frameTime * 0.05;
+			stats.fps = stats.frameTime > 0 ? 1000.0 / stats.frameTime : 0;
+			if (Core::frameDeadline > 0 && frameTime > Core::frameDeadline * 1.5)
+				stats.missedFrames++;
+		}
+		stats.frames++;
+		Core::lastPresent = end;
+
+		// wait until start of next frame
+		const RenderSettings &render = Core::renderSettings;
+		if (render.targetFps <= 0 || render.pacing == NoPacing || !Core::replayRealSpeed)
+			return;
+		Uint64 frequency = SDL_GetPerformanceFrequency();
+		Uint64 interval = frequency / render.targetFps;
+		if (Core::nextFrame == 0 || end > Core::nextFrame + interval)
+			Core::nextFrame = end; // too late, don't try to catch up
+		Core::nextFrame += interval;
+		Uint64 spin = render.pacing == PrecisePacing ? frequency / 500 : 0;
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now + spin < Core::nextFrame)
+			SDL_Delay(Uint32(Core::counterToMilliseconds(Core::nextFrame - spin - now)));
+		if (render.pacing == PrecisePacing)
+			while (SDL_GetPerformanceCounter() < Core::nextFrame) {
+			}
+	}
+
+	void setRenderSettings(const RenderSettings &settings) {
+		Core::renderSettings = settings;
+	}
+
+	RenderStats getRenderStats() {
+		return Core::renderStats;
+	}
+
+	std::string getRendererName() {
+		SDL_RendererInfo info;
+		if (Core::renderer == nullptr || SDL_GetRendererInfo(Core::renderer, &info) != 0)
+			return "";
+		return info.name;
+	}
+
+	bool isAdaptivePresent() {
+		return Core::adaptivePresent;
+	}
+
+	bool startCapture(const CaptureSettings &settings) {
+		stopCapture();
+		if (Core::renderer == nullptr || SDL_GetRendererOutputSize(Core::renderer, &Core::captureWidth,
+			&Core::captureHeight) != 0)
+			return false;
+
+		Core::captureSettings = settings;
+		CaptureSettings &capture = Core::captureSettings;
+		if (capture.bufferCount < 1)
+			capture.bufferCount = 1;
+		if (capture.frameInterval < 1)
+			capture.frameInterval = 1;
+		if (capture.workers < 1 || capture.format == Y4mCapture)
+			capture.workers = 1;
+
+		if (capture.format == Y4mCapture) {
+			// 4:2:0 chroma needs even size
+			Core::captureWidth &= ~1;
+			Core::captureHeight &= ~1;
+			Core::captureVideo = SDL_RWFromFile(capture.path.c_str(), "wb");
+			if (Core::captureVideo == nullptr)
+				return false;
+			char header[96];
+			int length = SDL_snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n",
+				Core::captureWidth, Core::captureHeight, capture.fps);
+			SDL_RWwrite(Core::captureVideo, header, length, 1);
+		}
+
+		static bool exitHandlerRegistered = false;
+		if (!exitHandlerRegistered) {
+			atexit(stopCapture);
+			exitHandlerRegistered = true;
+		}
+
+		Core::captureBuffers.assign(capture.bufferCount, Core::CaptureBuffer());
+		for (size_t i = 0; i < Core::captureBuffers.size(); i++)
+			Core::captureBuffers[i].pixels.resize(size_t(Core::captureWidth) * Core::captureHeight * 4);
+		Core::captureQueue.clear();
+		Core::captureStats = CaptureStats();
+		Core::captureFrameCounter = 0;
+		Core::captureStopping = false;
+		if (Core::captureMutex == nullptr) {
+			Core::captureMutex = SDL_CreateMutex();
+			Core::captureCondition = SDL_CreateCond();
+		}
+		for (int i = 0; i < capture.workers; i++)
+			Core::captureWorkers.push_back(SDL_CreateThread(Core::encodeFrames, "SBDL capture", nullptr));
+		Core::capturing = true;
+		return true;
+	}
+
+	void stopCapture() {
+		if (!Core::capturing)
+			return;
+		Core::capturing = false;
+
+		// workers finish queued frames and then exit
+		SDL_LockMutex(Core::captureMutex);
+		Core::captureStopping = true;
+		SDL_CondBroadcast(Core::captureCondition);
+		SDL_UnlockMutex(Core::captureMutex);
+		for (size_t i = 0; i < Core::captureWorkers.size(); i++)
+			SDL_WaitThread(Core::captureWorkers[i], nullptr);
+		Core::captureWorkers.clear();
+
+		if (Core::captureVideo) {
+			SDL_RWclose(Core::captureVideo);
+			Core::captureVideo = nullptr;
+		}
+		std::vector<Core::CaptureBuffer>().swap(Core::captureBuffers);
+	}
+
+	CaptureStats getCaptureStats() {
+		if (Core::captureMutex == nullptr)
+			return Core::captureStats;
+		SDL_LockMutex(Core::captureMutex);
+		CaptureStats stats = Core::captureStats;
+		SDL_UnlockMutex(Core::captureMutex);
+		return stats;
+	}
+
+	void delay(Uint32 frameRate) {
+		if (!Core::replayRealSpeed)
+			return;
+		SDL_Delay(frameRate);
+	}
+
+	Font *loadFont(const std::string &path, int size) {
+		Font *font = TTF_OpenFont(path.c_str(), size);
+		Core::trackResource(font, FontResource, 0);
+		return font;
+	}
+
+	void freeFont(Font *font) {
+		Core::untrackResource(font);
+		TTF_CloseFont(font);
+	}
+
+	void setResourceTag(const std::string &tag) {
+		Core::resourceTag = tag;
+	}
+
+	ResourceStats getResourceStats(ResourceType type) {
+		return Core::resourceStats[type];
+	}
+
+	void dumpResources() {
+		const char *names[ResourceTypeCount] = { "Texture", "Sound", "CompressedSound", "Music", "Font" };
+		std::unordered_map<std::string, std::pair<int, size_t> > groups;
+		for (std::unordered_map<const void *, Core::TrackedResource>::const_iterator it = Core::trackedResources.begin();
+			it != Core::trackedResources.end(); ++it) {
+			std::pair<int, size_t> &group = groups[std::string(names[it->second.type]) + " [" + it->second.tag + "]"];
+			group.first++;
+			group.second += it->second.bytes;
+		}
+		for (std::unordered_map<std::string, std::pair<int, size_t> >::const_iterator it = groups.begin();
+			it != groups.end(); ++it)
+			SDL_Log("SBDL: %d %s not freed (%lu bytes)", it->second.first, it->first.c_str(),
+				(unsigned long)it->second.second);
+	}
+
+	void Core::reportLeakedResources() {
+		if (!trackedResources.empty())
+			dumpResources();
+	}
+
+	Texture loadTexture(const std::string &path, Uint8 alpha) {
+		return Core::loadTextureUnderneath(path, false, 0, 0, 0, alpha);
+	}
+
+	Texture loadTexture(const std::string &path, Uint8 r, Uint8 g, Uint8 b, Uint8 alpha) {
+		return Core::loadTextureUnderneath(path, true, r, g, b, alpha);
+	}
+
+	void setSoundPriority(Sound *sound, int priority, int maxInstances) {
+		Core::SoundRule &rule = Core::soundRules[sound];
+		rule.priority = priority;
+		rule.maxInstances = maxInstances;
+	}
+
+	void playSound(Sound *sound, int count) {
+		if (count == 0)
+			return;
+		int loops = (count > 0) ? count - 1 : -1;
+		if (Core::voices.empty()) {
+			Mix_PlayChannel(-1, sound, loops);
+			return;
+		}
+
+		Core::SoundRule rule;
+		std::unordered_map<const Sound *, Core::SoundRule>::const_iterator found = Core::soundRules.find(sound);
+		if (found != Core::soundRules.end())
+			rule = found->second;
+
+		// find a free voice, oldest instance of this sound and weakest voice
+		int freeVoice = -1, oldestInstance = -1, weakestVoice = -1, instances = 0;
+		for (int i = 0; i < int(Core::voices.size()); i++) {
+			Core::Voice &voice = Core::voices[i];
+			if (!Mix_Playing(i)) {
+				voice.sound = nullptr;
+				if (freeVoice == -1)
+					freeVoice = i;
+				continue;
+			}
+			if (voice.sound == sound) {
+				instances++;
+				if (oldestInstance == -1 || voice.order < Core::voices[oldestInstance].order)
+					oldestInstance = i;
+			}
+			if (weakestVoice == -1 || voice.priority < Core::voices[weakestVoice].priority ||
+				(voice.priority == Core::voices[weakestVoice].priority &&
+					voice.order < Core::voices[weakestVoice].order))
+				weakestVoice = i;
+		}
+
+		int channel = freeVoice;
+		if (rule.maxInstances > 0 && instances >= rule.maxInstances)
+			channel = oldestInstance;
+		else if (channel == -1 && Core::voices[weakestVoice].priority <= rule.priority)
+			channel = weakestVoice;
+		if (channel == -1) {
+			Core::droppedSounds++;
+			return;
+		}
+		if (channel != freeVoice) {
+			Mix_HaltChannel(channel);
+			Core::stolenVoices++;
+		}
+
+		if (Mix_PlayChannel(channel, sound, loops) == -1)
+			return;
+		Core::Voice &voice = Core::voices[channel];
+		voice.sound = sound;
+		voice.priority = rule.priority;
+		voice.order = Core::voiceOrder++;
+	}
+
+	void playMusic(Music *music, int count) {
+		Mix_PlayMusic(music, count);
+	}
+
+	Sound *loadSound(const std::string &path) {
+		Sound *sound;
+		sound = Mix_LoadWAV(path.c_str());
+		if (!sound) {
+			const std::string message = "Unable to load: " + path;
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load sound error", message.c_str(), nullptr);
+			exit(1);
+		}
+		Core::trackResource(sound, SoundResource, sound->alen);
+		return sound;
+	}
+
+	Music *loadMusic(const std::string &path) {
+		Music *music;
+		music = Mix_LoadMUS(path.c_str());
+		if (!music) {
+			const std::string message = "Unable to load: " + path;
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load music error", message.c_str(), nullptr);
+			exit(1);
+		}
+		Core::trackResource(music, MusicResource, 0);
+		return music;
+	}
+
+	void stopMusic() {
+		Mix_HaltMusic();
+	}
+
+	void stopAllSounds() {
+		Mix_HaltChannel(-1);
+	}
+
+	void freeSound(Sound *sound) {
+		for (int i = 0; i < int(Core::voices.size()); i++)
+			if (Core::voices[i].sound == sound) {
+				Mix_HaltChannel(i);
+				Core::voices[i].sound = nullptr;
+			}
+		Core::soundRules.erase(sound);
+		Core::untrackResource(sound);
+		Mix_FreeChunk(sound);
+	}
+
+	CompressedSound *loadCompressedSound(const std::string &path) {
+		size_t size = 0;
+		void *content = SDL_LoadFile(path.c_str(), &size);
+		if (!content) {
+			const std::string message = "Unable to load: " + path;
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load sound error", message.c_str(), nullptr);
+			exit(1);
+		}
+		CompressedSound *sound = new CompressedSound;
+		sound->data.assign(static_cast<Uint8 *>(content), static_cast<Uint8 *>(content) + size);
+		SDL_free(content);
+		Core::compressedSounds.push_back(sound);
+		Core::trackResource(sound, CompressedSoundResource, sound->data.size());
+		return sound;
+	}
+
+	void preloadSound(CompressedSound *sound) {
+		if (!sound->decoded && !sound->decoding)
+			Core::requestDecode(sound);
+	}
+
+	void playSound(CompressedSound *sound, int count) {
+		if (count == 0)
+			return;
+		sound->lastUsed = Core::soundUseOrder++;
+		if (sound->decoded) {
+			Core::soundCacheHits++;
+			playSound(sound->decoded, count);
+			return;
+		}
+		Core::soundCacheMisses++;
+		sound->pendingPlays.push_back(count);
+		if (!sound->decoding)
+			Core::requestDecode(sound);
+	}
+
+	void setSoundPriority(CompressedSound *sound, int priority, int maxInstances) {
+		sound->priority = priority;
+		sound->maxInstances = maxInstances;
+		if (sound->decoded)
+			setSoundPriority(sound->decoded, priority, maxInstances);
+	}
+
+	void setSoundCacheSize(size_t bytes) {
+		Core::soundCacheLimit = bytes;
+	}
+
+	SoundCacheInfo getSoundCacheInfo() {
+		SoundCacheInfo info;
+		info.compressedBytes = 0;
+		for (size_t i = 0; i < Core::compressedSounds.size(); i++)
+			info.compressedBytes += Core::compressedSounds[i]->data.size();
+		info.decodedBytes = Core::soundCacheBytes;
+		info.hits = Core::soundCacheHits;
+		info.misses = Core::soundCacheMisses;
+		return info;
+	}
+
+	void Core::playDecodedSounds() {
+		if (decoderThread == nullptr)
+			return;
+
+		std::vector<std::pair<CompressedSound *, Sound *> > finished;
+		SDL_LockMutex(decoderMutex);
+		finished.swap(decodedQueue);
+		SDL_UnlockMutex(decoderMutex);
+
+		for (size_t i = 0; i < finished.size(); i++) {
+			CompressedSound *sound = finished[i].first;
+			sound->decoding = false;
+			sound->decoded = finished[i].second;
+			if (!sound->decoded) {
+				sound->pendingPlays.clear();
+				continue;
+			}
+			sound->decodedBytes = sound->decoded->alen;
+			soundCacheBytes += sound->decodedBytes;
+			if (sound->priority != 0 || sound->maxInstances != 0)
+				setSoundPriority(sound->decoded, sound->priority, sound->maxInstances);
+			for (size_t j = 0; j < sound->pendingPlays.size(); j++)
+				SBDL::playSound(sound->decoded, sound->pendingPlays[j]);
+			sound->pendingPlays.clear();
+		}
+
+		// remove least recently used sounds which are not playing until cache fits in its limit
+		while (soundCacheBytes > soundCacheLimit) {
+			CompressedSound *oldest = nullptr;
+			for (size_t i = 0; i < compressedSounds.size(); i++) {
+				CompressedSound *sound = compressedSounds[i];
+				if (!sound->decoded || (oldest && sound->lastUsed >= oldest->lastUsed))
+					continue;
+				bool playing = false;
+				for (int v = 0; v < int(voices.size()) && !playing; v++)
+					playing = voices[v].sound == sound->decoded && Mix_Playing(v);
+				if (!playing)
+					oldest = sound;
+			}
+			if (!oldest)
+				break;
+			soundCacheBytes -= oldest->decodedBytes;
+			freeSound(oldest->decoded);
+			oldest->decoded = nullptr;
+			oldest->decodedBytes = 0;
+		}
+	}
+
+	void freeSound(CompressedSound *sound) {
+		if (Core::decoderThread) {
+			// make sure decoder thread is not using this sound
+			SDL_LockMutex(Core::decoderMutex);
+			while (Core::decodingSound == sound)
+				SDL_CondWait(Core::decoderCondition, Core::decoderMutex);
+			Core::decodeQueue.erase(std::remove(Core::decodeQueue.begin(), Core::decodeQueue.end(), sound),
+				Core::decodeQueue.end());
+			for (size_t i = 0; i < Core::decodedQueue.size(); i++)
+				if (Core::decodedQueue[i].first == sound) {
+					if (Core::decodedQueue[i].second)
+						Mix_FreeChunk(Core::decodedQueue[i].second);
+					Core::decodedQueue.erase(Core::decodedQueue.begin() + i);
+					break;
+				}
+			SDL_UnlockMutex(Core::decoderMutex);
+		}
+		if (sound->decoded) {
+			Core::soundCacheBytes -= sound->decodedBytes;
+			freeSound(sound->decoded);
+		}
+		Core::compressedSounds.erase(std::remove(Core::compressedSounds.begin(), Core::compressedSounds.end(), sound),
+			Core::compressedSounds.end());
+		Core::untrackResource(sound);
+		delete sound;
+	}
+
+	void freeMusic(Music *music) {
+		Core::untrackResource(music);
+		Mix_FreeMusic(music);
+	}
+
+	void freeTexture(Texture &texture) {
+		Core::untrackResource(texture.underneathTexture);
+		SDL_DestroyTexture(texture.underneathTexture);
+		texture.underneathTexture = nullptr;
+		texture.width = 0;
+		texture.height = 0;
+	}
+
+	Texture createFontTexture(Font *font, const std::string &text, Uint8 r, Uint8 g, Uint8 b) {
+		SDL_Color color;
+		color.r = r;
+		color.g = g;
+		color.b = b;
+		SDL_Surface *temp = TTF_RenderText_Solid(font, text.c_str(), color);
+
+		Texture newTexture;
+		newTexture.underneathTexture = SDL_CreateTextureFromSurface(Core::renderer, temp);
+		newTexture.width = temp->w;
+		newTexture.height = temp->h;
+
+		SDL_FreeSurface(temp);
+		Core::trackResource(newTexture.underneathTexture, TextureResource,
+			size_t(newTexture.width) * newTexture.height * 4);
+		return newTexture;
+	}
+
+	Texture createStreamingTexture(int width, int height) {
+		Texture newTexture;
+		newTexture.underneathTexture = SDL_CreateTexture(Core::renderer, SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STREAMING, width, height);
+		if (newTexture.underneathTexture == nullptr) {
+			const std::string message = std::string("Unable to create texture: ") + SDL_GetError();
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL create texture error", message.c_str(), nullptr);
+			exit(1);
+		}
+		newTexture.width = width;
+		newTexture.height = height;
+		SDL_SetTextureBlendMode(newTexture.underneathTexture, SDL_BLENDMODE_BLEND);
+		Core::trackResource(newTexture.underneathTexture, TextureResource, size_t(width) * height * 4);
+		return newTexture;
+	}
+
+	bool lockTexture(Texture &texture, PixelBuffer &buffer, const SDL_Rect *area) {
+		// SDL doesn't clip locked area, so a part outside of texture would be written out of bounds
+		SDL_Rect locked = { 0, 0, texture.width, texture.height };
+		const SDL_Rect bounds = locked;
+		if (area && !SDL_IntersectRect(area, &bounds, &locked))
+			return false;
+		void *pixels;
+		if (SDL_LockTexture(texture.underneathTexture, &locked, &pixels, &buffer.pitch) != 0)
+			return false;
+		buffer.pixels = static_cast<Uint32 *>(pixels);
+		buffer.width = locked.w;
+		buffer.height = locked.h;
+		return true;
+	}
+
+	void unlockTexture(Texture &texture) {
+		SDL_UnlockTexture(texture.underneathTexture);
+	}
+
+	void updateTexture(Texture &texture, const SDL_Rect &area, const Uint32 *pixels, int pitch) {
+		SDL_UpdateTexture(texture.underneathTexture, &area, pixels, pitch);
+	}
+
+	SweepHit sweepRect(const SDL_Rect &movingRect, float vx, float vy, const SDL_Rect &targetRect) {
+		SweepHit result;
+		const float infinity = std::numeric_limits<float>::infinity();
+
+		// distance to enter and exit target on each axis
+		float xEntry, xExit, yEntry, yExit;
+		if (vx > 0) {
+			xEntry = float(targetRect.x - (movingRect.x + movingRect.w));
+			xExit = float(targetRect.x + targetRect.w - movingRect.x);
+		}
+		else {
+			xEntry = float(targetRect.x + targetRect.w - movingRect.x);
+			xExit = float(targetRect.x - (movingRect.x + movingRect.w));
+		}
+		if (vy > 0) {
+			yEntry = float(targetRect.y - (movingRect.y + movingRect.h));
+			yExit = float(targetRect.y + targetRect.h - movingRect.y);
+		}
+		else {
+			yEntry = float(targetRect.y + targetRect.h - movingRect.y);
+			yExit = float(targetRect.y - (movingRect.y + movingRect.h));
+		}
+
+		// convert distances to times, a still axis must overlap during whole move
+		float txEntry, txExit, tyEntry, tyExit;
+		if (vx == 0) {
+			if (movingRect.x + movingRect.w <= targetRect.x || movingRect.x >= targetRect.x + targetRect.w)
+				return result;
+			txEntry = -infinity;
+			txExit = infinity;
+		}
+		else {
+			txEntry = xEntry / vx;
+			txExit = xExit / vx;
+		}
+		if (vy == 0) {
+			if (movingRect.y + movingRect.h <= targetRect.y || movingRect.y >= targetRect.y + targetRect.h)
+				return result;
+			tyEntry = -infinity;
+			tyExit = infinity;
+		}
+		else {
+			tyEntry = yEntry / vy;
+			tyExit = yExit / vy;
+		}
+
+		float entryTime = txEntry > tyEntry ? txEntry : tyEntry;
+		float exitTime = txExit < tyExit ? txExit : tyExit;
+		if (entryTime >= exitTime || entryTime < 0 || entryTime > 1)
+			return result;
+
+		result.hit = true;
+		result.time = entryTime;
+		if (txEntry > tyEntry)
+			result.normalX = vx > 0 ? -1 : 1;
+		else
+			result.normalY = vy > 0 ? -1 : 1;
+		return result;
+	}
+
+	SweepHit sweepRect(const SDL_Rect &movingRect, float vx, float vy, const SDL_Rect *targetRects, int count) {
+		SweepHit first;
+
+		// bounding box of whole move, rectangles outside of it can't be hit
+		SDL_Rect area = movingRect;
+		if (vx < 0)
+			area.x += int(vx) - 1;
+		if (vy < 0)
+			area.y += int(vy) - 1;
+		area.w += int(vx < 0 ? -vx : vx) + 2;
+		area.h += int(vy < 0 ? -vy : vy) + 2;
+
+		for (int i = 0; i < count; i++) {
+			if (!hasIntersectionRect(area, targetRects[i]))
+				continue;
+			SweepHit current = sweepRect(movingRect, vx, vy, targetRects[i]);
+			if (current.hit && (!first.hit || current.time < first.time)) {
+				first = current;
+				first.index = i;
+			}
+		}
+		return first;
+	}
+
+	SweepHit sweepRect(const SDL_Rect &movingRect, float vx, float vy, const std::vector<SDL_Rect> &targetRects) {
+		return sweepRect(movingRect, vx, vy, targetRects.data(), int(targetRects.size()));
+	}
+
+	void drawRectangle(const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 alpha) {
+		Uint8 defaults[4];
+		SDL_GetRenderDrawColor(Core::renderer, &defaults[0], &defaults[1], &defaults[2], &defaults[3]);
+		SDL_SetRenderDrawColor(Core::renderer, r, g, b, alpha);
+		SDL_RenderFillRect(Core::renderer, &rect);
+		SDL_SetRenderDrawColor(Core::renderer, defaults[0], defaults[1], defaults[2], defaults[3]);
+	}
+
+	void drawSprites(World &world) {
+		ComponentPool<Sprite> &sprites = world.sprites;
+		for (int i = 0; i < sprites.size(); i++) {
+			const Sprite &sprite = sprites.at(i);
+			if (sprite.angle == 0 && sprite.flip == SDL_FLIP_NONE)
+				SDL_RenderCopy(Core::renderer, sprite.texture.underneathTexture, nullptr, &sprite.rect);
+			else
+				SDL_RenderCopyEx(Core::renderer, sprite.texture.underneathTexture, nullptr, &sprite.rect,
+					sprite.angle, nullptr, sprite.flip);
+		}
+	}
+
+	void findCollisions(World &world, std::vector<CollisionPair> &pairs) {
+		pairs.clear();
+		ComponentPool<Collider> &colliders = world.colliders;
+
+		std::vector<World::CollisionInterval> &intervals = world.intervals;
+		intervals.clear();
+		for (int i = 0; i < colliders.size(); i++) {
+			// empty rects never intersect, same as hasIntersectionRect
+			const SDL_Rect &rect = colliders.at(i).rect;
+			if (SDL_RectEmpty(&rect))
+				continue;
+			World::CollisionInterval interval = { rect.x, rect.x + rect.w, i };
+			intervals.push_back(interval);
+		}
+		std::sort(intervals.begin(), intervals.end(), [](const World::CollisionInterval &a,
+			const World::CollisionInterval &b) {
+			return a.minX < b.minX;
+		});
+
+		for (size_t i = 0; i < intervals.size(); i++) {
+			const Collider &first = colliders.at(intervals[i].slot);
+			for (size_t j = i + 1; j < intervals.size() && intervals[j].minX < intervals[i].maxX; j++) {
+				const Collider &second = colliders.at(intervals[j].slot);
+				if (!(first.layer & second.mask) || !(second.layer & first.mask))
+					continue;
+				if (first.rect.y < second.rect.y + second.rect.h && second.rect.y < first.rect.y + first.rect.h) {
+					CollisionPair pair;
+					pair.first = colliders.entityAt(intervals[i].slot);
+					pair.second = colliders.entityAt(intervals[j].slot);
+					pairs.push_back(pair);
+				}
+			}
+		}
+	}
+
+	void findCollisions(World &world, const SDL_Rect &rect, std::vector<Entity> &result) {
+		result.clear();
+		ComponentPool<Collider> &colliders = world.colliders;
+		for (int i = 0; i < colliders.size(); i++)
+			if (hasIntersectionRect(colliders.at(i).rect, rect))
+				result.push_back(colliders.entityAt(i));
+	}
+
+	namespace Core {
+		/**
+		* 8 directions of movement on a NavGrid, straight ones have even index
+		* direction i + 4 is opposite of direction i
+		*/
+		const int directionX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		const int directionY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+		const int directionCost[8] = { 10, 14, 10, 14, 10, 14, 10, 14 };
+
+		/**
+		* direction for none
+		*/
+		const Uint8 noDirection = 255;
+
+		/**
+		* unreachable distance
+		*/
+		const int unreachable = std::numeric_limits<int>::max();
+
+		/**
+		* check if agent can step from (x, y) in a direction
+		* step is symmetric, so it is also the check for stepping back
+		*/
+		bool canStep(const NavGrid &grid, int x, int y, int direction) {
+			int dx = directionX[direction], dy = directionY[direction];
+			if (grid.isBlocked(x + dx, y + dy))
+				return false;
+			return (dx == 0 || dy == 0) || (!grid.isBlocked(x + dx, y) && !grid.isBlocked(x, y + dy));
+		}
+
+		/**
+		* cost of moving between two tiles in a straight or diagonal line
+		*/
+		int octileDistance(int x1, int y1, int x2, int y2) {
+			int dx = x1 > x2 ? x1 - x2 : x2 - x1;
+			int dy = y1 > y2 ? y1 - y2 : y2 - y1;
+			return dx > dy ? 10 * dx + 4 * dy : 10 * dy + 4 * dx;
+		}
+
+		int sign(int value) {
+			return (value > 0) - (value < 0);
+		}
+
+		/**
+		* order of heap, smallest cost first
+		*/
+		bool heapOrder(const std::pair<int, int> &a, const std::pair<int, int> &b) {
+			return a.first > b.first;
+		}
+	}
+
+	NavGrid::NavGrid(int width, int height, int tileSize)
+		: width(width), height(height), tileSize(tileSize), blocked(size_t(width) * height, 0) {
+	}
+
+	void NavGrid::setBlocked(int x, int y, bool block) {
+		if (x < 0 || y < 0 || x >= width || y >= height || blocked[y * width + x] == Uint8(block))
+			return;
+		blocked[y * width + x] = block;
+
+		// keep a limited history, fields which missed removed changes compute themselves again
+		if (changes.size() >= blocked.size()) {
+			removedChanges += Uint32(changes.size());
+			changes.clear();
+		}
+		changes.push_back(y * width + x);
+	}
+
+	void NavGrid::setBlocked(const SDL_Rect &area, bool block) {
+		if (SDL_RectEmpty(&area))
+			return;
+		SDL_Point first = tileAt(area.x, area.y);
+		SDL_Point last = tileAt(area.x + area.w - 1, area.y + area.h - 1);
+		first.x = std::max(first.x, 0);
+		first.y = std::max(first.y, 0);
+		last.x = std::min(last.x, width - 1);
+		last.y = std::min(last.y, height - 1);
+		for (int y = first.y; y <= last.y; y++)
+			for (int x = first.x; x <= last.x; x++)
+				setBlocked(x, y, block);
+	}
+
+	int NavGrid::jump(int x, int y, int dx, int dy, int goalX, int goalY) const {
+		while (true) {
+			if (isBlocked(x, y))
+				return -1;
+			if (x == goalX && y == goalY)
+				return y * width + x;
+
+			if (dx != 0 && dy != 0) {
+				// a diagonal move stops where one of its straight parts finds something
+				if (jump(x + dx, y, dx, 0, goalX, goalY) != -1 || jump(x, y + dy, 0, dy, goalX, goalY) != -1)
+					return y * width + x;
+				if (isBlocked(x + dx, y) || isBlocked(x, y + dy))
+					return -1;
+			}
+			else if (dx != 0) {
+				// a tile beside is open now but was blocked beside previous tile
+				if ((!isBlocked(x, y - 1) && isBlocked(x - dx, y - 1)) ||
+					(!isBlocked(x, y + 1) && isBlocked(x - dx, y + 1)))
+					return y * width + x;
+			}
+			else {
+				if ((!isBlocked(x - 1, y) && isBlocked(x - 1, y - dy)) ||
+					(!isBlocked(x + 1, y) && isBlocked(x + 1, y - dy)))
+					return y * width + x;
+			}
+			x += dx;
+			y += dy;
+		}
+	}
+
+	bool NavGrid::findPath(SDL_Point start, SDL_Point goal, std::vector<SDL_Point> &path) {
+		path.clear();
+		if (isBlocked(start.x, start.y) || isBlocked(goal.x, goal.y))
+			return false;
+		if (start.x == goal.x && start.y == goal.y) {
+			path.push_back(start);
+			return true;
+		}
+
+		if (pathCost.size() != blocked.size()) {
+			pathCost.assign(blocked.size(), 0);
+			pathParent.assign(blocked.size(), -1);
+			openStamp.assign(blocked.size(), 0);
+			closedStamp.assign(blocked.size(), 0);
+		}
+		if (++searchId == 0) { // stamps wrapped around, forget all of them
+			std::fill(openStamp.begin(), openStamp.end(), 0);
+			std::fill(closedStamp.begin(), closedStamp.end(), 0);
+			searchId = 1;
+		}
+
+		const int startIndex = start.y * width + start.x;
+		const int goalIndex = goal.y * width + goal.x;
+		openList.clear();
+		openList.push_back(std::make_pair(Core::octileDistance(start.x, start.y, goal.x, goal.y), startIndex));
+		openStamp[startIndex] = searchId;
+		pathCost[startIndex] = 0;
+		pathParent[startIndex] = -1;
+
+		while (!openList.empty()) {
+			std::pop_heap(openList.begin(), openList.end(), Core::heapOrder);
+			int current = openList.back().second;
+			openList.pop_back();
+			if (closedStamp[current] == searchId)
+				continue;
+			closedStamp[current] = searchId;
+
+			if (current == goalIndex) {
+				for (int i = goalIndex; i != -1; i = pathParent[i]) {
+					SDL_Point tile = { i % width, i / width };
+					path.push_back(tile);
+				}
+				std::reverse(path.begin(), path.end());
+				return true;
+			}
+
+			int x = current % width, y = current / width;
+			int parent = pathParent[current];
+
+			// directions which may lead to a shorter path than going through parent
+			int directions[8][2];
+			int count = 0;
+			if (parent == -1) {
+				for (int i = 0; i < 8; i++)
+					if (Core::canStep(*this, x, y, i)) {
+						directions[count][0] = Core::directionX[i];
+						directions[count++][1] = Core::directionY[i];
+					}
+			}
+			else {
+				int dx = Core::sign(x - parent % width), dy = Core::sign(y - parent / width);
+				if (dx != 0 && dy != 0) {
+					bool openX = !isBlocked(x + dx, y), openY = !isBlocked(x, y + dy);
+					if (openY) {
+						directions[count][0] = 0;
+						directions[count++][1] = dy;
+					}
+					if (openX) {
+						directions[count][0] = dx;
+						directions[count++][1] = 0;
+					}
+					if (openX && openY) {
+						directions[count][0] = dx;
+						directions[count++][1] = dy;
+					}
+				}
+				else {
+					// side directions are perpendicular to movement
+					int sideX = dy != 0, sideY = dx != 0;
+					bool openNext = !isBlocked(x + dx, y + dy);
+					bool openSide1 = !isBlocked(x + sideX, y + sideY), openSide2 = !isBlocked(x - sideX, y - sideY);
+					if (openNext) {
+						directions[count][0] = dx;
+						directions[count++][1] = dy;
+						if (openSide1) {
+							directions[count][0] = dx + sideX;
+							directions[count++][1] = dy + sideY;
+						}
+						if (openSide2) {
+							directions[count][0] = dx - sideX;
+							directions[count++][1] = dy - sideY;
+						}
+					}
+					if (openSide1) {
+						directions[count][0] = sideX;
+						directions[count++][1] = sideY;
+					}
+					if (openSide2) {
+						directions[count][0] = -sideX;
+						directions[count++][1] = -sideY;
+					}
+				}
+			}
+
+			for (int i = 0; i < count; i++) {
+				int dx = directions[i][0], dy = directions[i][1];
+				int found = jump(x + dx, y + dy, dx, dy, goal.x, goal.y);
+				if (found == -1 || closedStamp[found] == searchId)
+					continue;
+				int foundX = found % width, foundY = found / width;
+				int cost = pathCost[current] + Core::octileDistance(x, y, foundX, foundY);
+				if (openStamp[found] != searchId || cost < pathCost[found]) {
+					openStamp[found] = searchId;
+					pathCost[found] = cost;
+					pathParent[found] = current;
+					openList.push_back(std::make_pair(cost + Core::octileDistance(foundX, foundY, goal.x, goal.y), found));
+					std::push_heap(openList.begin(), openList.end(), Core::heapOrder);
+				}
+			}
+		}
+		return false;
+	}
+
+	FlowField::FlowField(const NavGrid &grid) : grid(grid) {
+		target.x = target.y = -1;
+		distances.assign(grid.blocked.size(), Core::unreachable);
+		next.assign(grid.blocked.size(), Core::noDirection);
+		invalid.assign(grid.blocked.size(), 0);
+	}
+
+	void FlowField::setTarget(SDL_Point tile) {
+		target = tile;
+		rebuild();
+	}
+
+	void FlowField::push(int distance, int index) {
+		heap.push_back(std::make_pair(distance, index));
+		std::push_heap(heap.begin(), heap.end(), Core::heapOrder);
+	}
+
+	void FlowField::rebuild() {
+		std::fill(distances.begin(), distances.end(), Core::unreachable);
+		std::fill(next.begin(), next.end(), Core::noDirection);
+		appliedChanges = grid.removedChanges + Uint32(grid.changes.size());
+		heap.clear();
+		if (grid.isBlocked(target.x, target.y))
+			return;
+		int index = target.y * grid.width + target.x;
+		distances[index] = 0;
+		push(0, index);
+		propagate();
+	}
+
+	void FlowField::propagate() {
+		const int width = grid.width;
+		while (!heap.empty()) {
+			std::pop_heap(heap.begin(), heap.end(), Core::heapOrder);
+			int distance = heap.back().first, index = heap.back().second;
+			heap.pop_back();
+			if (distance != distances[index])
+				continue;
+			int x = index % width, y = index / width;
+			for (int i = 0; i < 8; i++) {
+				if (!Core::canStep(grid, x, y, i))
+					continue;
+				int neighbor = index + Core::directionY[i] * width + Core::directionX[i];
+				int neighborDistance = distance + Core::directionCost[i];
+				if (neighborDistance < distances[neighbor]) {
+					distances[neighbor] = neighborDistance;
+					next[neighbor] = Uint8((i + 4) % 8);
+					push(neighborDistance, neighbor);
+				}
+			}
+		}
+	}
+
+	void FlowField::update() {
+		Uint32 total = grid.removedChanges + Uint32(grid.changes.size());
+		if (appliedChanges == total)
+			return;
+		if (appliedChanges < grid.removedChanges || grid.isBlocked(target.x, target.y) ||
+			distances[target.y * grid.width + target.x] != 0) {
+			rebuild();
+			return;
+		}
+
+		const int width = grid.width, height = grid.height;
+		const int targetIndex = target.y * width + target.x;
+		invalidTiles.clear();
+
+		// changed tiles and neighbors which their next step is not possible anymore are invalid
+		for (Uint32 c = appliedChanges - grid.removedChanges; c < grid.changes.size(); c++) {
+			int changed = grid.changes[c];
+			int cx = changed % width, cy = changed / width;
+			for (int i = -1; i < 8; i++) {
+				int x = cx + (i == -1 ? 0 : Core::directionX[i]);
+				int y = cy + (i == -1 ? 0 : Core::directionY[i]);
+				if (x < 0 || y < 0 || x >= width || y >= height)
+					continue;
+				int index = y * width + x;
+				if (invalid[index] || index == targetIndex)
+					continue;
+				if (index == changed || grid.isBlocked(x, y) ||
+					(next[index] != Core::noDirection && !Core::canStep(grid, x, y, next[index]))) {
+					invalid[index] = 1;
+					invalidTiles.push_back(index);
+				}
+			}
+		}
+
+		// tiles which their next step goes to an invalid tile are invalid too
+		for (size_t t = 0; t < invalidTiles.size(); t++) {
+			int index = invalidTiles[t];
+			int x = index % width, y = index / width;
+			for (int i = 0; i < 8; i++) {
+				int nx = x + Core::directionX[i], ny = y + Core::directionY[i];
+				if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+					continue;
+				int neighbor = ny * width + nx;
+				if (!invalid[neighbor] && next[neighbor] == (i + 4) % 8) {
+					invalid[neighbor] = 1;
+					invalidTiles.push_back(neighbor);
+				}
+			}
+		}
+		for (size_t t = 0; t < invalidTiles.size(); t++) {
+			distances[invalidTiles[t]] = Core::unreachable;
+			next[invalidTiles[t]] = Core::noDirection;
+		}
+
+		// start invalid tiles from their best valid neighbor
+		heap.clear();
+		for (size_t t = 0; t < invalidTiles.size(); t++) {
+			int index = invalidTiles[t];
+			int x = index % width, y = index / width;
+			if (grid.isBlocked(x, y))
+				continue;
+			for (int i = 0; i < 8; i++) {
+				if (!Core::canStep(grid, x, y, i))
+					continue;
+				int neighbor = index + Core::directionY[i] * width + Core::directionX[i];
+				if (invalid[neighbor] || distances[neighbor] == Core::unreachable)
+					continue;
+				int distance = distances[neighbor] + Core::directionCost[i];
+				if (distance < distances[index]) {
+					distances[index] = distance;
+					next[index] = Uint8(i);
+				}
+			}
+			if (distances[index] != Core::unreachable)
+				push(distances[index], index);
+		}
+
+		// an unblocked tile may open shorter ways for its neighbors
+		for (Uint32 c = appliedChanges - grid.removedChanges; c < grid.changes.size(); c++) {
+			int changed = grid.changes[c];
+			int cx = changed % width, cy = changed / width;
+			if (grid.isBlocked(cx, cy))
+				continue;
+			for (int i = 0; i < 8; i++) {
+				int x = cx + Core::directionX[i], y = cy + Core::directionY[i];
+				if (x < 0 || y < 0 || x >= width || y >= height)
+					continue;
+				int index = y * width + x;
+				if (!invalid[index] && distances[index] != Core::unreachable)
+					push(distances[index], index);
+			}
+		}
+
+		for (size_t t = 0; t < invalidTiles.size(); t++)
+			invalid[invalidTiles[t]] = 0;
+		appliedChanges = total;
+		propagate();
+	}
+
+	SDL_Point FlowField::direction(SDL_Point tile) const {
+		SDL_Point result = { 0, 0 };
+		if (tile.x < 0 || tile.y < 0 || tile.x >= grid.width || tile.y >= grid.height)
+			return result;
+		Uint8 step = next[tile.y * grid.width + tile.x];
+		if (step != Core::noDirection) {
+			result.x = Core::directionX[step];
+			result.y = Core::directionY[step];
+		}
+		return result;
+	}
+
+	int FlowField::distance(SDL_Point tile) const {
+		if (tile.x < 0 || tile.y < 0 || tile.x >= grid.width || tile.y >= grid.height)
+			return -1;
+		int value = distances[tile.y * grid.width + tile.x];
+		return value == Core::unreachable ? -1 : value;
+	}
+}
@@ -2,10 +2,13 @@
 * SBDL: Sadegh & Borjian Directmedia Layer!
 */
 
+#ifndef SBDL_H
+#define SBDL_H
+
 #include <string>
+#include <vector>
 
 #if defined(_WIN32) || defined(_WIN64) // Windows
-#pragma once
 #include "SDL.h"
 #include "SDL_image.h"
 #include "SDL_ttf.h"
@@ -36,6 +39,49 @@ using Music = Mix_Music;
 * */
 using Font = TTF_Font;
 
+/**
+* represent a Sound which is kept compressed in memory and decoded when it is played
+* don't use its fields directly in your code
+* @see loadCompressedSound
+* */
+struct CompressedSound {
+	/**
+	* content of sound file (.ogg or .wav)
+	*/
+	std::vector<Uint8> data;
+
+	/**
+	* decoded sound, nullptr if it is not in cache
+	*/
+	Sound *decoded = nullptr;
+
+	/**
+	* size of decoded sound in bytes
+	*/
+	Uint32 decodedBytes = 0;
+
+	/**
+	* when decoded sound was used last time, for finding least recently used one
+	*/
+	Uint32 lastUsed = 0;
+
+	/**
+	* true if sound is waiting for decoder
+	*/
+	bool decoding = false;
+
+	/**
+	* count of each play which must start after decoding
+	*/
+	std::vector<int> pendingPlays;
+
+	/**
+	* playing rule which is applied to decoded sound
+	*/
+	int priority = 0;
+	int maxInstances = 0;
+};
+
 /**
 * Texture living on the graphics card that can be used for drawing.
 */
@@ -59,87 +105,393 @@ struct Texture {
 
 namespace SBDL {
 	/**
-	* don't import this namespace
-	* this namespace used for handle underneath SDL functions for you
+	* audio output configuration, change it with setAudioSettings before InitEngine
 	*/
-	namespace Core {
+	struct AudioSettings {
 		/**
-		* current state of SDL
+		* output sample rate in Hz
 		*/
-		bool running = true;
+		int frequency = 22050;
 
 		/**
-		* SDL keyboard state array size
+		* output sample format (AUDIO_S16SYS, AUDIO_F32SYS, ...)
 		*/
-		int keystate_size = -1;
+		Uint16 format = AUDIO_S16SYS;
 
 		/**
-		* SDL current keyboard state
+		* number of output channels (1 for mono, 2 for stereo)
 		*/
-		const Uint8 *keystate = nullptr;
+		int channels = 2;
 
 		/**
-		* SDL last keyboard state
+		* samples per mixing buffer, smaller buffer has lower latency but needs more CPU wakeups
+		* drivers round it to their own period size, powers of two like 512 or 1024 are the safest choice
+		*/
+		int chunkSize = 640;
+
+		/**
+		* number of sounds which can play concurrently
 		*/
-		Uint8 *old_keystate = nullptr;
+		int voices = 16;
+	};
 
+	/**
+	* information about opened audio output
+	* @see getAudioInfo
+	*/
+	struct AudioInfo {
 		/**
-		* SDL current event
+		* sample rate which device accepted
 		*/
-		SDL_Event event;
+		int frequency;
 
 		/**
-		* SDL windows
+		* sample format which device accepted
 		*/
-		SDL_Window *window = nullptr;
+		Uint16 format;
 
 		/**
-		* SDL renderer
+		* number of channels which device accepted
 		*/
-		SDL_Renderer *renderer = nullptr;
+		int channels;
 
 		/**
-		 * create texture with given features
-		 * @param path path of texture
-		 * @param changeColor true if given color must be replaced with transparent color
-		 * @param r red color
-		 * @param g green color
-		 * @param b blue color
-		 * @param alpha transparency level
-		 * @return texture which is created
-		 */
-		Texture loadTextureUnderneath(const std::string &path, bool changeColor, Uint8 r, Uint8 g, Uint8 b,
-			Uint8 alpha = 255) {
-			// Check existence of image
-			SDL_Surface *pic = IMG_Load(path.c_str());
-			if (pic == nullptr) {
-				const std::string message = "Missing Image file: " + path;
-				SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load image error", message.c_str(), nullptr);
-				exit(1);
-			}
+		* samples which are mixed in each audio callback, measured while playing
+		*/
+		int callbackSamples;
+
+		/**
+		* latency of one mixing buffer in milliseconds, measured while playing
+		* real output latency is usually two buffers
+		*/
+		double bufferLatency;
+
+		/**
+		* average time between two audio callbacks in milliseconds
+		*/
+		double callbackPeriod;
+
+		/**
+		* number of playing sounds which were stopped to play a more important sound
+		*/
+		int stolenVoices;
 
+		/**
+		* number of sounds which were not played because all voices were busy with more important sounds
+		*/
+		int droppedSounds;
+	};
 
-			if (changeColor)
-				SDL_SetColorKey(pic, SDL_TRUE, SDL_MapRGB(pic->format, r, g, b));
-			if (alpha != 255)
-				SDL_SetSurfaceAlphaMod(pic, alpha);
+	/**
+	* kind of renderer which draws textures
+	*/
+	enum RendererBackend {
+		/**
+		* let SDL choose, usually accelerated if available
+		*/
+		AutoRenderer,
 
-			Texture newTexture;
-			newTexture.underneathTexture = SDL_CreateTextureFromSurface(renderer, pic);
-			newTexture.width = pic->w;
-			newTexture.height = pic->h;
+		/**
+		* use graphics card
+		*/
+		AcceleratedRenderer,
 
-			SDL_SetTextureBlendMode(newTexture.underneathTexture, SDL_BLENDMODE_BLEND);
-			SDL_FreeSurface(pic);
+		/**
+		* draw with CPU, works everywhere but slow
+		*/
+		SoftwareRenderer
+	};
 
-			return newTexture;
-		}
+	/**
+	* how updateRenderScreen shows a frame
+	*/
+	enum PresentMode {
+		/**
+		* show frame immediately, lowest latency but may tear
+		*/
+		ImmediatePresent,
+
+		/**
+		* wait for display refresh, no tearing but late frames wait a whole refresh
+		*/
+		VsyncPresent,
+
+		/**
+		* wait for display refresh, but show late frames immediately
+		* SDL renderer has no adaptive vsync, so it works only with OpenGL drivers which support it
+		* and is VsyncPresent otherwise, check isAdaptivePresent after InitEngine
+		*/
+		AdaptivePresent
+	};
+
+	/**
+	* how updateRenderScreen waits to keep RenderSettings::targetFps
+	*/
+	enum FramePacing {
+		/**
+		* don't wait, you must delay yourself
+		*/
+		NoPacing,
+
+		/**
+		* sleep until next frame, uses least CPU but may wake up about 1 millisecond late
+		*/
+		SleepPacing,
+
+		/**
+		* sleep and then spin for last 2 milliseconds, more accurate but uses more CPU
+		*/
+		PrecisePacing
+	};
+
+	/**
+	* renderer configuration, change it with setRenderSettings before InitEngine
+	*/
+	struct RenderSettings {
+		/**
+		* kind of renderer
+		*/
+		RendererBackend backend = AutoRenderer;
+
+		/**
+		* how frames are shown
+		*/
+		PresentMode presentMode = ImmediatePresent;
+
+		/**
+		* name of SDL render driver to use ("direct3d", "opengl", "metal", ...), empty to let SDL choose
+		*/
+		std::string driver;
+
+		/**
+		* frames per second which updateRenderScreen tries to keep (0 for no limit)
+		*/
+		int targetFps = 0;
+
+		/**
+		* how updateRenderScreen waits for next frame when targetFps is set
+		*/
+		FramePacing pacing = SleepPacing;
+
+		/**
+		* don't show the window, useful for replaying input as a benchmark
+		*/
+		bool hiddenWindow = false;
+	};
+
+	/**
+	* timing of presented frames
+	* @see getRenderStats
+	*/
+	struct RenderStats {
+		/**
+		* number of frames presented since InitEngine
+		*/
+		Uint32 frames;
+
+		/**
+		* number of frames which were shown later than their deadline
+		* deadline is 1.5 frame of targetFps or display refresh rate, so no deadline if none of them is known
+		*/
+		Uint32 missedFrames;
+
+		/**
+		* milliseconds which last SDL_RenderPresent blocked
+		*/
+		double presentTime;
+
+		/**
+		* average milliseconds which SDL_RenderPresent blocked
+		*/
+		double averagePresentTime;
+
+		/**
+		* average milliseconds between two presented frames
+		*/
+		double frameTime;
+
+		/**
+		* frames per second which are really shown
+		*/
+		double fps;
+	};
+
+	/**
+	* file format of captured frames
+	*/
+	enum CaptureFormat {
+		/**
+		* one PNG image per frame, named path + frame number + ".png"
+		*/
+		PngCapture,
+
+		/**
+		* one raw YUV4MPEG2 video file in path, which can be played or converted by ffmpeg
+		*/
+		Y4mCapture
+	};
+
+	/**
+	* frame capture configuration
+	* @see startCapture
+	*/
+	struct CaptureSettings {
+		/**
+		* file format of captured frames
+		*/
+		CaptureFormat format = PngCapture;
+
+		/**
+		* prefix of PNG files or path of video file
+		*/
+		std::string path = "capture";
+
+		/**
+		* number of frames which can wait for encoding, a frame is dropped when all of them are full
+		*/
+		int bufferCount = 8;
+
+		/**
+		* number of threads which encode PNG files (video is always written by one thread)
+		*/
+		int workers = 2;
+
+		/**
+		* capture one frame of every frameInterval frames
+		*/
+		int frameInterval = 1;
+
+		/**
+		* frame rate which is written in video header
+		*/
+		int fps = 30;
+	};
+
+	/**
+	* statistics of frame capture
+	* @see getCaptureStats
+	*/
+	struct CaptureStats {
+		/**
+		* number of frames which are read from screen
+		*/
+		Uint32 captured;
+
+		/**
+		* number of frames which are not captured because all buffers were waiting for encoding
+		*/
+		Uint32 dropped;
+
+		/**
+		* number of frames which are written to disk
+		*/
+		Uint32 encoded;
+
+		/**
+		* number of frames which could not be written, like when disk is full
+		*/
+		Uint32 failed;
+
+		/**
+		* average milliseconds of reading a frame from screen, this is the only part which blocks the game
+		*/
+		double readTime;
+
+		/**
+		* average milliseconds of encoding and writing a frame in worker threads
+		*/
+		double encodeTime;
+	};
+
+	/**
+	* kinds of resources which SBDL allocates
+	* @see getResourceStats
+	*/
+	enum ResourceType {
+		TextureResource,
+		SoundResource,
+		CompressedSoundResource,
+		MusicResource,
+		FontResource,
+		ResourceTypeCount
+	};
+
+	/**
+	* usage of one kind of resource
+	* @see getResourceStats
+	*/
+	struct ResourceStats {
+		/**
+		* number of resources which are not freed yet
+		*/
+		int live;
+
+		/**
+		* estimated memory of live resources in bytes (music and fonts are streamed from disk and count as 0)
+		*/
+		size_t bytes;
+
+		/**
+		* number of resources created in previous frame
+		*/
+		int createdLastFrame;
+
+		/**
+		* number of resources freed in previous frame
+		*/
+		int destroyedLastFrame;
+
+		/**
+		* number of resources created since start of program
+		*/
+		int totalCreated;
+
+		/**
+		* number of resources freed since start of program
+		*/
+		int totalDestroyed;
+	};
+
+	/**
+	* don't import this namespace
+	* this namespace used for handle underneath SDL functions for you
+	*/
+	namespace Core {
+		/**
+		* current state of SDL
+		*/
+		extern bool running;
+
+		/**
+		* SDL current keyboard state
+		*/
+		extern const Uint8 *keystate;
+
+		/**
+		* SDL last keyboard state
+		*/
+		extern Uint8 *old_keystate;
+
+		/**
+		* SDL renderer
+		*/
+		extern SDL_Renderer *renderer;
+
+		/**
+		* true if getTime must return time of current frame, while recording or replaying input
+		*/
+		extern bool frameClock;
+
+		/**
+		* time of current frame, taken by updateEvents while recording or read from file while replaying
+		*/
+		extern Uint32 frameClockTime;
 	}
 
 	/**
 	* comparator of SDL_Rect
 	*/
-	bool operator==(const SDL_Rect &x, const SDL_Rect &y) {
+	inline bool operator==(const SDL_Rect &x, const SDL_Rect &y) {
 		return x.x == y.x && x.y == y.y && x.h == y.h && x.w == y.w;
 	}
 
@@ -197,20 +549,25 @@ namespace SBDL {
 		bool clicked(Uint8 button = SDL_BUTTON_LEFT, Uint8 clicks = 1, Uint8 state = SDL_PRESSED) {
 			return this->button == button && this->clicks == clicks && this->state == state;
 		}
-	} Mouse;
+	};
+
+	/**
+	* state of mouse
+	*/
+	extern struct Mouse Mouse;
 
 	/**
 	* check state of program
 	* @return state of SDL
 	*/
-	bool isRunning() {
+	inline bool isRunning() {
 		return Core::running;
 	}
 
 	/**
 	* stop SBDL and SBDL::isRunning will return false later
 	*/
-	void stop() {
+	inline void stop() {
 		Core::running = false;
 	}
 
@@ -219,7 +576,7 @@ namespace SBDL {
 	* @param scanCode specific code for each keyboard button (https://wiki.libsdl.org/SDL_Scancode)
 	* @return true if specific keyboard button was pressed
 	*/
-	bool keyPressed(SDL_Scancode scanCode) {
+	inline bool keyPressed(SDL_Scancode scanCode) {
 		return !Core::old_keystate[scanCode] && Core::keystate[scanCode];
 	}
 
@@ -228,7 +585,7 @@ namespace SBDL {
 	* @param scanCode specific code for each keyboard button (https://wiki.libsdl.org/SDL_Scancode)
 	* @return true if specific keyboard button was released
 	*/
-	bool keyReleased(SDL_Scancode scanCode) {
+	inline bool keyReleased(SDL_Scancode scanCode) {
 		return Core::old_keystate[scanCode] && !Core::keystate[scanCode];
 	}
 
@@ -237,10 +594,24 @@ namespace SBDL {
 	* @param scanCode specific code for each keyboard button (https://wiki.libsdl.org/SDL_Scancode)
 	* @return true if specific keyboard button is hold
 	*/
-	bool keyHeld(SDL_Scancode scanCode) {
+	inline bool keyHeld(SDL_Scancode scanCode) {
 		return Core::old_keystate[scanCode] && Core::keystate[scanCode];
 	}
 
+	/**
+	* change audio configuration
+	* call it before InitEngine, otherwise it has no effect
+	* @param settings new audio configuration
+	*/
+	void setAudioSettings(const AudioSettings &settings);
+
+	/**
+	* get information about audio output which is opened by InitEngine
+	* latency values are measured after first audio callback, so they are 0 just after InitEngine
+	* @return audio information
+	*/
+	AudioInfo getAudioInfo();
+
 	/**
 	* initialize SDL and show a simple empty window for drawing texture on it
 	* before start using SDL functions and types, first initialize engine
@@ -252,141 +623,144 @@ namespace SBDL {
 	* @param b blue color of default background
 	*/
 	void InitEngine(const std::string &windowsTitle, int windowsWidth, int windowsHeight,
-		Uint8 r = 255, Uint8 g = 255, Uint8 b = 255) {
-		atexit(SDL_Quit); // set a SDL_Quit as exit function
-		if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL initialization", "SBDL initialize video engine error",
-				nullptr);
-			exit(1);
-		}
-
-		SDL_CreateWindowAndRenderer(windowsWidth, windowsHeight, SDL_WINDOW_SHOWN, &Core::window, &Core::renderer);
-		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");  // make the scaled rendering look smoother
-		SDL_RenderSetLogicalSize(Core::renderer, windowsWidth, windowsHeight);
-		SDL_SetRenderDrawColor(Core::renderer, r, g, b, 255);
-		SDL_SetRenderDrawBlendMode(Core::renderer, SDL_BLENDMODE_BLEND);
-
-		SDL_SetWindowTitle(Core::window, windowsTitle.c_str());
-		// inilialize SDL_mixer, exit if fail
-		if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL initialization", "SBDL initialize audio engine error",
-				nullptr);
-			exit(1);
-		}
-
-		// setup audio mode
-		Mix_OpenAudio(22050, AUDIO_S16SYS, 2, 640);
-		// setup text system
-		TTF_Init();
-	}
+		Uint8 r = 255, Uint8 g = 255, Uint8 b = 255);
 
 	/**
 	* update state of keyboard buttons (release or push) and mouse
 	* if ESCAPE pressed, application will stop
 	* call this function in a loop after initialize engine for get updated state all times
 	*/
-	void updateEvents() {
-		// update keyboard state
-		if (Core::keystate_size == -1) {
-			Core::keystate = SDL_GetKeyboardState(&Core::keystate_size);
-			Core::old_keystate = new Uint8[Core::keystate_size];
-			for (int i = 0; i < Core::keystate_size; i++)
-				Core::old_keystate[i] = 0;
-		}
-		else {
-			for (int i = 0; i < Core::keystate_size; i++)
-				Core::old_keystate[i] = Core::keystate[i];
-			Core::keystate = SDL_GetKeyboardState(&Core::keystate_size);
-		}
-		SDL_PumpEvents();
-
-		// close app if ESCAPE pressed
-		if (keyPressed(SDL_SCANCODE_ESCAPE)) {
-			Core::running = false;
-		}
-
-		// reset event handler state for check it again
-		Core::event = {};
-
-		// returns true if there is an event in the queue, but will not remove it
-		if (!SDL_PollEvent(nullptr)) {
-			Mouse.left = Mouse.middle = Mouse.right = false;
-			Mouse.button = 0;
-			return;
-		}
-		while (SDL_PollEvent(&Core::event)) { // loop until there is a new event for handling
-			if (Core::event.type == SDL_MOUSEBUTTONDOWN || Core::event.type == SDL_MOUSEBUTTONUP) {
-				// update state of Mouse structure if it was changed
-				switch (Core::event.button.button) {
-				case 1:
-					Mouse.left = true;
-					Mouse.right = Mouse.middle = false;
-					break;
-				case 2:
-					Mouse.middle = true;
-					Mouse.right = Mouse.left = false;
-					break;
-				case 3:
-					Mouse.right = true;
-					Mouse.left = Mouse.middle = false;
-					break;
-				default:
-					Mouse.left = Mouse.middle = Mouse.right = false;
-				}
-
-				Mouse.state = Core::event.button.state;
-				Mouse.button = Core::event.button.button;
-				Mouse.clicks = Core::event.button.clicks;
-			}
-			// update position of mouse if it was changed
-			if (Core::event.type == SDL_MOUSEMOTION) {
-				Mouse.x = Core::event.motion.x;
-				Mouse.y = Core::event.motion.y;
-			}
-			if (Core::event.type == SDL_QUIT) {
-				Core::running = false;
-			}
-		}
-	}
+	void updateEvents();
 
 	/**
 	* get Milliseconds since program was started.
+	* while recording or replaying input, time of current frame is returned, so both runs see the same time
 	*/
-	unsigned int getTime() {
-		return SDL_GetTicks();
+	inline unsigned int getTime() {
+		return Core::frameClock ? Core::frameClockTime : SDL_GetTicks();
 	}
 
 	/**
-	* clear the current rendering target
+	* start writing state of keyboard, Mouse and quit requests of every updateEvents call to a file
+	* @param path path of the file to write
+	* @return false if file can't be created
+	* @see startReplay
 	*/
-	void clearRenderScreen() {
-		SDL_RenderClear(Core::renderer);
-	}
+	bool startRecording(const std::string &path);
 
 	/**
-	* update the screen and apply all changes
+	* stop writing input to file which is opened with startRecording
 	*/
-	void updateRenderScreen() {
-		SDL_RenderPresent(Core::renderer);
-	}
+	void stopRecording();
 
 	/**
-	* wait a few milliseconds before continue process of application
-	* @param frameRate set the dalay (milisecond)
+	* feed input which is recorded with startRecording to updateEvents instead of real keyboard and mouse
+	* getTime returns recorded time of each frame, so game plays exactly like recorded session
+	* when recorded frames finish, replay stops and SBDL::isRunning will return false
+	* @param path path of the recorded file
+	* @param realSpeed false to skip SBDL::delay and frame pacing, so replay runs as fast as possible
+	* @return false if file can't be opened or is not a recorded file
 	*/
-	void delay(Uint32 frameRate) {
-		SDL_Delay(frameRate);
-	}
+	bool startReplay(const std::string &path, bool realSpeed = false);
 
 	/**
-	* load the font from a file
-	* @param path path of the font file to load
-	* @param size size of font
-	* @return font which is loaded
+	* @return true if input is replayed from a file
 	*/
-	Font *loadFont(const std::string &path, int size) {
-		return TTF_OpenFont(path.c_str(), size);
-	}
+	bool isReplaying();
+
+	/**
+	* clear the current rendering target
+	*/
+	void clearRenderScreen();
+
+	/**
+	* update the screen and apply all changes
+	*/
+	void updateRenderScreen();
+
+	/**
+	* change renderer configuration
+	* call it before InitEngine, otherwise it has no effect
+	* @param settings new renderer configuration
+	*/
+	void setRenderSettings(const RenderSettings &settings);
+
+	/**
+	* get timing of presented frames
+	* @return timing statistics which are updated by updateRenderScreen
+	*/
+	RenderStats getRenderStats();
+
+	/**
+	* get name of SDL render driver which is used ("direct3d", "opengl", "software", ...)
+	*/
+	std::string getRendererName();
+
+	/**
+	* @return true if AdaptivePresent is requested and the driver really shows late frames immediately
+	*/
+	bool isAdaptivePresent();
+
+	/**
+	* start saving every frame which is shown with updateRenderScreen
+	* frames are copied to preallocated buffers and encoded in other threads, so game doesn't wait for disk
+	* if encoding is slower than game, frames are dropped instead
+	* call it after InitEngine
+	* @param settings capture configuration
+	* @return false if capture can't be started
+	*/
+	bool startCapture(const CaptureSettings &settings);
+
+	/**
+	* stop capturing and wait until captured frames are written
+	* it is called automatically when program exits
+	*/
+	void stopCapture();
+
+	/**
+	* @return statistics of current or last frame capture
+	*/
+	CaptureStats getCaptureStats();
+
+	/**
+	* wait a few milliseconds before continue process of application
+	* @param frameRate set the dalay (milisecond)
+	*/
+	void delay(Uint32 frameRate);
+
+	/**
+	* load the font from a file
+	* @param path path of the font file to load
+	* @param size size of font
+	* @return font which is loaded
+	*/
+	Font *loadFont(const std::string &path, int size);
+
+	/**
+	* free memory which is used for load font from file
+	* @param font Font which you want to destroy
+	*/
+	void freeFont(Font *font);
+
+	/**
+	* attach a tag to resources which are loaded after this call, for finding where a leaked resource was created
+	* @param tag name of current part of program (empty for no tag)
+	*/
+	void setResourceTag(const std::string &tag);
+
+	/**
+	* get usage of one kind of resource
+	* frame counters are updated by updateRenderScreen
+	* @param type kind of resource
+	* @return usage of that kind of resource
+	*/
+	ResourceStats getResourceStats(ResourceType type);
+
+	/**
+	* write all resources which are not freed yet to log, grouped by type and tag
+	* it is called automatically when program exits
+	*/
+	void dumpResources();
 
 	/**
 	* load the texture from a file on disk
@@ -394,9 +768,7 @@ namespace SBDL {
 	* @param alpha transparency level
 	* @return texture which is loaded
 	*/
-	Texture loadTexture(const std::string &path, Uint8 alpha = 255) {
-		return Core::loadTextureUnderneath(path, false, 0, 0, 0, alpha);
-	}
+	Texture loadTexture(const std::string &path, Uint8 alpha = 255);
 
 	/**
 	* load the texture from a file on disk and replace transparency of image with specific color
@@ -407,21 +779,27 @@ namespace SBDL {
 	* @param alpha transparency level
 	* @return texture which is loaded
 	*/
-	Texture loadTexture(const std::string &path, Uint8 r, Uint8 g, Uint8 b, Uint8 alpha = 255) {
-		return Core::loadTextureUnderneath(path, true, r, g, b, alpha);
-	}
+	Texture loadTexture(const std::string &path, Uint8 r, Uint8 g, Uint8 b, Uint8 alpha = 255);
+
+	/**
+	* set how important a sound is when all voices are busy
+	* @param sound sound which is loaded before
+	* @param priority sound with higher priority can stop sound with lower or equal priority to play
+	* @param maxInstances maximum number of this sound which can play concurrently, oldest one is stopped
+	for playing a new one (0 for no limit)
+	*/
+	void setSoundPriority(Sound *sound, int priority, int maxInstances = 0);
 
 	/**
 	* play sound
 	* multiple sound can play concurrently
+	* if all voices are busy, oldest sound with lowest priority is stopped
 	* @param sound sound which is loaded before
 	* @param count frequency of sound (-1 to play all time)
 	* @see loadSound
+	* @see setSoundPriority
 	*/
-	void playSound(Sound *sound, int count) {
-		if (count != 0)
-			Mix_PlayChannel(-1, sound, (count > 0) ? count - 1 : -1);
-	}
+	void playSound(Sound *sound, int count);
 
 	/**
 	* play music
@@ -430,83 +808,124 @@ namespace SBDL {
 	* @param count frequency of msuic (-1 to play all time)
 	* @see loadMusic
 	*/
-	void playMusic(Music *music, int count) {
-		Mix_PlayMusic(music, count);
-	}
+	void playMusic(Music *music, int count);
 
 	/**
 	* load sound from a file in disk (use .wav)
 	* @param path path of the sound file to load
 	* @return sound which is loaded
 	*/
-	Sound *loadSound(const std::string &path) {
-		Sound *sound;
-		sound = Mix_LoadWAV(path.c_str());
-		if (!sound) {
-			const std::string message = "Unable to load: " + path;
-			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load sound error", message.c_str(), nullptr);
-			exit(1);
-		}
-		return sound;
-	}
+	Sound *loadSound(const std::string &path);
 
 	/**
 	* load music from a file in disk (use .ogg or .wav)
 	* @param path path of the music file to load
 	* @return music which is loaded
 	*/
-	Music *loadMusic(const std::string &path) {
-		Music *music;
-		music = Mix_LoadMUS(path.c_str());
-		if (!music) {
-			const std::string message = "Unable to load: " + path;
-			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "SBDL load music error", message.c_str(), nullptr);
-			exit(1);
-		}
-		return music;
-	}
+	Music *loadMusic(const std::string &path);
 
 	/**
 	* stop music
 	*/
-	void stopMusic() {
-		Mix_HaltMusic();
-	}
+	void stopMusic();
 
 	/**
 	* stop all sounds
 	*/
-	void stopAllSounds() {
-		Mix_HaltChannel(-1);
-	}
+	void stopAllSounds();
 
 	/**
 	* free memory which is used for load sound from file
 	* @param sound Sound which you want to destroy
 	*/
-	void freeSound(Sound *sound) {
-		Mix_FreeChunk(sound);
-	}
+	void freeSound(Sound *sound);
+
+	/**
+	* load sound from a file in disk (use .ogg or .wav) and keep it compressed in memory
+	* sound is decoded in another thread when it is played and decoded sound is cached for next plays
+	* so it needs much less memory than loadSound but its first play may start one frame later
+	* @param path path of the sound file to load
+	* @return sound which is loaded
+	* @see setSoundCacheSize
+	*/
+	CompressedSound *loadCompressedSound(const std::string &path);
+
+	/**
+	* decode a compressed sound before it is needed, so its first play starts without delay
+	* @param sound sound which is loaded before
+	*/
+	void preloadSound(CompressedSound *sound);
+
+	/**
+	* play compressed sound
+	* if sound is not decoded yet, it starts playing after decoding is finished
+	* @param sound sound which is loaded before
+	* @param count frequency of sound (-1 to play all time)
+	* @see loadCompressedSound
+	*/
+	void playSound(CompressedSound *sound, int count);
+
+	/**
+	* set how important a compressed sound is when all voices are busy
+	* @see setSoundPriority
+	*/
+	void setSoundPriority(CompressedSound *sound, int priority, int maxInstances = 0);
+
+	/**
+	* set maximum memory of decoded compressed sounds which are kept for playing again
+	* least recently used sounds are removed from memory when limit is reached
+	* @param bytes size of cache in bytes
+	*/
+	void setSoundCacheSize(size_t bytes);
+
+	/**
+	* information about memory and cache usage of compressed sounds
+	*/
+	struct SoundCacheInfo {
+		/**
+		* bytes of all compressed sound files
+		*/
+		size_t compressedBytes;
+
+		/**
+		* bytes of decoded sounds which are in cache
+		*/
+		size_t decodedBytes;
+
+		/**
+		* number of plays which found decoded sound in cache
+		*/
+		int hits;
+
+		/**
+		* number of plays which needed decoding
+		*/
+		int misses;
+	};
+
+	/**
+	* @return information about memory and cache usage of compressed sounds
+	*/
+	SoundCacheInfo getSoundCacheInfo();
+
+	/**
+	* free memory which is used for compressed sound and its decoded data
+	* @param sound CompressedSound which you want to destroy
+	*/
+	void freeSound(CompressedSound *sound);
 
 	/**
 	* free memory which is used for load music from file
 	* @param music Music which you want to destroy
 	*/
-	void freeMusic(Music *music) {
-		Mix_FreeMusic(music);
-	}
+	void freeMusic(Music *music);
 
 	/**
 	* free memory which is used for texture
 	* After call this function, texture is not usable anymore and any using has undefined behavior
 	* @param texture Texture which you want to destroy
 	*/
-	void freeTexture(Texture &texture) {
-		SDL_DestroyTexture(texture.underneathTexture);
-		texture.underneathTexture = nullptr;
-		texture.width = 0;
-		texture.height = 0;
-	}
+	void freeTexture(Texture &texture);
 
 	/**
 	* texture showed in render screen in position destRect with angle and flip
@@ -515,7 +934,7 @@ namespace SBDL {
 	* @param destRect custom rect to draw texture
 	* @param flip flipping actions performed on the texture (SDL_FLIP_NONE or SDL_FLIP_HORIZONTAL or SDL_FLIP_VERTICAL)
 	*/
-	void showTexture(const Texture &texture, double angle, const SDL_Rect &destRect,
+	inline void showTexture(const Texture &texture, double angle, const SDL_Rect &destRect,
 		SDL_RendererFlip flip = SDL_FLIP_NONE) {
 		SDL_RenderCopyEx(Core::renderer, texture.underneathTexture, nullptr, &destRect, angle, nullptr,
 			flip);
@@ -530,7 +949,7 @@ namespace SBDL {
 	in a clockwise direction around center of texture
 	* @param flip flipping actions performed on the texture (SDL_FLIP_NONE or SDL_FLIP_HORIZONTAL or SDL_FLIP_VERTICAL)
 	*/
-	void showTexture(const Texture &texture, int x, int y, double angle, SDL_RendererFlip flip = SDL_FLIP_NONE) {
+	inline void showTexture(const Texture &texture, int x, int y, double angle, SDL_RendererFlip flip = SDL_FLIP_NONE) {
 		SDL_Rect rect;
 		rect.x = x;
 		rect.y = y;
@@ -544,7 +963,7 @@ namespace SBDL {
 	* @param texture the source texture
 	* @param destRect custom rect to draw texture
 	*/
-	void showTexture(const Texture &texture, const SDL_Rect &destRect) {
+	inline void showTexture(const Texture &texture, const SDL_Rect &destRect) {
 		SDL_RenderCopy(Core::renderer, texture.underneathTexture, nullptr, &destRect);
 	}
 
@@ -554,7 +973,7 @@ namespace SBDL {
 	* @param x position x
 	* @param y position y
 	*/
-	void showTexture(const Texture &texture, int x, int y) {
+	inline void showTexture(const Texture &texture, int x, int y) {
 		SDL_Rect rect;
 		rect.x = x;
 		rect.y = y;
@@ -572,32 +991,167 @@ namespace SBDL {
 	* @param b blue color
 	* @return texture which created with that font and text
 	*/
-	Texture createFontTexture(Font *font, const std::string &text, Uint8 r, Uint8 g, Uint8 b) {
-		SDL_Color color;
-		color.r = r;
-		color.g = g;
-		color.b = b;
-		SDL_Surface *temp = TTF_RenderText_Solid(font, text.c_str(), color);
+	Texture createFontTexture(Font *font, const std::string &text, Uint8 r, Uint8 g, Uint8 b);
+
+	/**
+	* pixels of a locked streaming texture
+	* each pixel is 32 bit ARGB, use mapColor for making it
+	* @see lockTexture
+	*/
+	struct PixelBuffer {
+		/**
+		* first pixel of locked area
+		*/
+		Uint32 *pixels = nullptr;
 
-		Texture newTexture;
-		newTexture.underneathTexture = SDL_CreateTextureFromSurface(Core::renderer, temp);
-		newTexture.width = temp->w;
-		newTexture.height = temp->h;
+		/**
+		* length of a row in bytes, may be bigger than width * 4
+		*/
+		int pitch = 0;
 
-		SDL_FreeSurface(temp);
-		return newTexture;
+		/**
+		* width of locked area
+		*/
+		int width = 0;
+
+		/**
+		* height of locked area
+		*/
+		int height = 0;
+
+		/**
+		* first pixel of row y of locked area
+		* @param y row number <0 to height - 1>
+		*/
+		Uint32 *row(int y) const {
+			return reinterpret_cast<Uint32 *>(reinterpret_cast<Uint8 *>(pixels) + y * pitch);
+		}
+	};
+
+	/**
+	* make a pixel value for PixelBuffer
+	* @param r red color
+	* @param g green color
+	* @param b blue color
+	* @param alpha transparency level
+	* @return pixel value
+	*/
+	inline Uint32 mapColor(Uint8 r, Uint8 g, Uint8 b, Uint8 alpha = 255) {
+		return (Uint32(alpha) << 24) | (Uint32(r) << 16) | (Uint32(g) << 8) | Uint32(b);
 	}
 
+	/**
+	* create a texture which its pixels can be changed every frame without creating a new texture
+	* content of a new texture is undefined, fill it before showing
+	* @param width width of texture
+	* @param height height of texture
+	* @return texture which is created
+	* @see lockTexture
+	* @see updateTexture
+	*/
+	Texture createStreamingTexture(int width, int height);
+
+	/**
+	* get direct access to pixels of a streaming texture, write pixels and then call unlockTexture
+	* locked pixels are write only, their old content is not kept, so write all pixels of locked area
+	* @param texture texture which is created with createStreamingTexture
+	* @param buffer pixels of locked area
+	* @param area part of texture to lock (nullptr for whole texture), it is clipped to texture
+	* @return false if texture can't be locked or area is outside of texture
+	*/
+	bool lockTexture(Texture &texture, PixelBuffer &buffer, const SDL_Rect *area = nullptr);
+
+	/**
+	* upload pixels which are written after lockTexture
+	* @param texture texture which is locked before
+	*/
+	void unlockTexture(Texture &texture);
+
+	/**
+	* copy pixels from memory to a part of texture
+	* @param texture texture which is created with createStreamingTexture
+	* @param area part of texture to update
+	* @param pixels ARGB pixels of area
+	* @param pitch length of a row of pixels in bytes
+	*/
+	void updateTexture(Texture &texture, const SDL_Rect &area, const Uint32 *pixels, int pitch);
+
 	/**
 	* check intersection of two SDL_Rect
 	* @param firstRect first rectangle
 	* @param secondRect second rectangle
 	* @return true if has intersection
 	*/
-	bool hasIntersectionRect(const SDL_Rect &firstRect, const SDL_Rect &secondRect) {
+	inline bool hasIntersectionRect(const SDL_Rect &firstRect, const SDL_Rect &secondRect) {
 		return SDL_HasIntersection(&firstRect, &secondRect) == SDL_TRUE;
 	}
 
+	/**
+	* result of a swept collision query
+	* @see sweepRect
+	*/
+	struct SweepHit {
+		/**
+		* true if moving rectangle hits something during this move
+		*/
+		bool hit = false;
+
+		/**
+		* time of impact as a fraction of the velocity <0 to 1>
+		* moving rectangle can safely move (vx * time, vy * time) before touching
+		*/
+		float time = 1.0f;
+
+		/**
+		* normal of the contacted side < -1, 0 or 1 >
+		* reflect velocity on this axis to bounce
+		*/
+		int normalX = 0;
+
+		/**
+		* normal of the contacted side < -1, 0 or 1 >
+		*/
+		int normalY = 0;
+
+		/**
+		* index of the contacted rectangle in the given array (-1 if nothing hit)
+		*/
+		int index = -1;
+	};
+
+	/**
+	* check continuous collision of a moving rectangle with a still rectangle
+	* unlike hasIntersectionRect, fast objects can't pass through thin rectangles between two frames
+	* rectangles which already intersect movingRect at start of move are ignored
+	* @param movingRect rectangle at start of move
+	* @param vx movement in x during this frame
+	* @param vy movement in y during this frame
+	* @param targetRect still rectangle
+	* @return information about first contact
+	*/
+	SweepHit sweepRect(const SDL_Rect &movingRect, float vx, float vy, const SDL_Rect &targetRect);
+
+	/**
+	* check continuous collision of a moving rectangle with some still rectangles and find the first contact
+	* @param movingRect rectangle at start of move
+	* @param vx movement in x during this frame
+	* @param vy movement in y during this frame
+	* @param targetRects array of still rectangles
+	* @param count number of rectangles in targetRects
+	* @return information about first contact, index shows which rectangle was hit
+	*/
+	SweepHit sweepRect(const SDL_Rect &movingRect, float vx, float vy, const SDL_Rect *targetRects, int count);
+
+	/**
+	* check continuous collision of a moving rectangle with some still rectangles and find the first contact
+	* @param movingRect rectangle at start of move
+	* @param vx movement in x during this frame
+	* @param vy movement in y during this frame
+	* @param targetRects still rectangles
+	* @return information about first contact, index shows which rectangle was hit
+	*/
+	SweepHit sweepRect(const SDL_Rect &movingRect, float vx, float vy, const std::vector<SDL_Rect> &targetRects);
+
 	/**
 	* Draw rectangle on renderer screen.
 	* @param rect rectangle position
@@ -606,13 +1160,7 @@ namespace SBDL {
 	* @param b blue color
 	* @param alpha transparency
 	*/
-	void drawRectangle(const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 alpha = 255) {
-		Uint8 defaults[4];
-		SDL_GetRenderDrawColor(Core::renderer, &defaults[0], &defaults[1], &defaults[2], &defaults[3]);
-		SDL_SetRenderDrawColor(Core::renderer, r, g, b, alpha);
-		SDL_RenderFillRect(Core::renderer, &rect);
-		SDL_SetRenderDrawColor(Core::renderer, defaults[0], defaults[1], defaults[2], defaults[3]);
-	}
+	void drawRectangle(const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 alpha = 255);
 
 	/**
 	* Check if a point is inside a Rect
@@ -621,7 +1169,7 @@ namespace SBDL {
 	* @param rect the rectangle to check with
 	* @return true if point is inside the rectangle
 	*/
-	bool pointInRect(int x, int y, const SDL_Rect &rect) {
+	inline bool pointInRect(int x, int y, const SDL_Rect &rect) {
 		SDL_Point point;
 		point.x = x;
 		point.y = y;
@@ -633,7 +1181,585 @@ namespace SBDL {
 	* @param rect check when mouse is inside this rectangle
 	* @return true if mouse is inside the rectangle
 	*/
-	bool mouseInRect(const SDL_Rect &rect) {
+	inline bool mouseInRect(const SDL_Rect &rect) {
 		return pointInRect(Mouse.x, Mouse.y, rect);
 	}
+
+	/**
+	* handle of an entity in a World
+	* a handle of a destroyed entity never becomes valid again, even if its index is reused
+	*/
+	struct Entity {
+		/**
+		* slot of entity in world
+		*/
+		Uint32 index = 0;
+
+		/**
+		* how many times the slot was reused, used for detecting stale handles
+		*/
+		Uint32 generation = 0;
+	};
+
+	/**
+	* comparator of Entity
+	*/
+	inline bool operator==(const Entity &x, const Entity &y) {
+		return x.index == y.index && x.generation == y.generation;
+	}
+
+	/**
+	* don't use it directly in your code
+	* common part of all component pools which lets World remove components of destroyed entities
+	*/
+	struct ComponentPoolBase {
+		virtual ~ComponentPoolBase() {}
+
+		virtual void remove(Entity entity) = 0;
+	};
+
+	/**
+	* dense storage for one type of component
+	* components are packed in a contiguous array, so iterating over them touches only memory which is used
+	* removing a component moves the last one into its place, so order of components is not stable
+	*/
+	template <typename T>
+	class ComponentPool : public ComponentPoolBase {
+	public:
+		/**
+		* add a component to an entity or replace its current one
+		* pool can't know if entity is destroyed, use World::addComponent to check it
+		* @param entity owner of component
+		* @param component value of component
+		* @return stored component or nullptr if slot belongs to a newer entity of same index
+		*/
+		T *add(Entity entity, const T &component) {
+			if (entity.index >= sparse.size())
+				sparse.resize(entity.index + 1, Uint32(invalid));
+			Uint32 slot = sparse[entity.index];
+			if (slot != invalid) {
+				// generations only grow, so an older owner is a destroyed one
+				if (entities[slot].generation > entity.generation)
+					return nullptr;
+				entities[slot] = entity;
+				components[slot] = component;
+				return &components[slot];
+			}
+			sparse[entity.index] = Uint32(components.size());
+			entities.push_back(entity);
+			components.push_back(component);
+			return &components.back();
+		}
+
+		/**
+		* remove component of an entity, does nothing if entity has not this component
+		* @param entity owner of component
+		*/
+		void remove(Entity entity) override {
+			if (!has(entity))
+				return;
+			Uint32 slot = sparse[entity.index];
+			Uint32 last = Uint32(components.size() - 1);
+			if (slot != last) {
+				components[slot] = components[last];
+				entities[slot] = entities[last];
+				sparse[entities[slot].index] = slot;
+			}
+			components.pop_back();
+			entities.pop_back();
+			sparse[entity.index] = invalid;
+		}
+
+		/**
+		* @param entity entity to check
+		* @return true if entity has this component
+		*/
+		bool has(Entity entity) const {
+			return entity.index < sparse.size() && sparse[entity.index] != invalid &&
+				entities[sparse[entity.index]].generation == entity.generation;
+		}
+
+		/**
+		* get component of an entity, entity must have this component
+		* @param entity owner of component
+		*/
+		T &get(Entity entity) {
+			return components[sparse[entity.index]];
+		}
+
+		/**
+		* get component of an entity or nullptr if entity has not this component
+		* @param entity owner of component
+		*/
+		T *find(Entity entity) {
+			return has(entity) ? &components[sparse[entity.index]] : nullptr;
+		}
+
+		/**
+		* number of stored components
+		*/
+		int size() const {
+			return int(components.size());
+		}
+
+		/**
+		* component at position i of dense array <0 to size - 1>
+		*/
+		T &at(int i) {
+			return components[i];
+		}
+
+		/**
+		* owner of component at position i of dense array <0 to size - 1>
+		*/
+		Entity entityAt(int i) const {
+			return entities[i];
+		}
+
+		/**
+		* call function(entity, component) for every stored component
+		* don't add or remove components of this pool inside function
+		*/
+		template <typename Function>
+		void forEach(Function function) {
+			for (size_t i = 0; i < components.size(); i++)
+				function(entities[i], components[i]);
+		}
+
+	private:
+		static const Uint32 invalid = 0xFFFFFFFF;
+
+		/**
+		* packed components
+		*/
+		std::vector<T> components;
+
+		/**
+		* owner of each packed component
+		*/
+		std::vector<Entity> entities;
+
+		/**
+		* position of component of each entity index in packed array
+		*/
+		std::vector<Uint32> sparse;
+	};
+
+	/**
+	* component for drawing an entity with SBDL::drawSprites
+	*/
+	struct Sprite {
+		/**
+		* texture which is drawn
+		*/
+		Texture texture;
+
+		/**
+		* position and size of texture on screen
+		*/
+		SDL_Rect rect;
+
+		/**
+		* rotation in degrees, clockwise around center of rect
+		*/
+		double angle = 0;
+
+		/**
+		* flipping actions performed on the texture (SDL_FLIP_NONE or SDL_FLIP_HORIZONTAL or SDL_FLIP_VERTICAL)
+		*/
+		SDL_RendererFlip flip = SDL_FLIP_NONE;
+	};
+
+	/**
+	* component for finding touching entities with SBDL::findCollisions
+	*/
+	struct Collider {
+		/**
+		* area of entity which can be hit
+		*/
+		SDL_Rect rect;
+
+		/**
+		* two colliders can touch only if (first.layer & second.mask) != 0 and (second.layer & first.mask) != 0
+		*/
+		Uint32 layer = 1;
+
+		/**
+		* layers which this collider can touch
+		*/
+		Uint32 mask = 0xFFFFFFFF;
+	};
+
+	/**
+	* pair of entities which their colliders have intersection
+	*/
+	struct CollisionPair {
+		Entity first;
+		Entity second;
+	};
+
+	/**
+	* container of entities and their components
+	* sprites and colliders are built in, register your own ComponentPool to clean it when entities are destroyed
+	*/
+	class World {
+	public:
+		/**
+		* sprite components
+		*/
+		ComponentPool<Sprite> sprites;
+
+		/**
+		* collider components
+		*/
+		ComponentPool<Collider> colliders;
+
+		World() {
+			pools.push_back(&sprites);
+			pools.push_back(&colliders);
+		}
+
+		World(const World &) = delete;
+		World &operator=(const World &) = delete;
+
+		/**
+		* create a new entity without any component
+		* @return handle of new entity
+		*/
+		Entity createEntity() {
+			Entity entity;
+			if (!freeIndices.empty()) {
+				entity.index = freeIndices.back();
+				freeIndices.pop_back();
+			}
+			else {
+				entity.index = Uint32(generations.size());
+				generations.push_back(0);
+			}
+			entity.generation = generations[entity.index];
+			aliveCount++;
+			return entity;
+		}
+
+		/**
+		* destroy an entity and remove all of its components from registered pools
+		* handle of entity and all of its copies become invalid
+		* @param entity entity to destroy
+		*/
+		void destroyEntity(Entity entity) {
+			if (!isAlive(entity))
+				return;
+			for (size_t i = 0; i < pools.size(); i++)
+				pools[i]->remove(entity);
+			generations[entity.index]++;
+			freeIndices.push_back(entity.index);
+			aliveCount--;
+		}
+
+		/**
+		* @param entity entity to check
+		* @return true if entity is not destroyed yet
+		*/
+		bool isAlive(Entity entity) const {
+			return entity.index < generations.size() && generations[entity.index] == entity.generation;
+		}
+
+		/**
+		* add a component to an alive entity or replace its current one
+		* @param entity owner of component
+		* @param pool pool of component, like sprites or colliders
+		* @param component value of component
+		* @return stored component or nullptr if entity is destroyed
+		*/
+		template <typename T>
+		T *addComponent(Entity entity, ComponentPool<T> &pool, const T &component) {
+			if (!isAlive(entity))
+				return nullptr;
+			return pool.add(entity, component);
+		}
+
+		/**
+		* number of alive entities
+		*/
+		int entityCount() const {
+			return aliveCount;
+		}
+
+		/**
+		* register a component pool to remove components of destroyed entities from it
+		* pool must live longer than world
+		* @param pool pool of your own component
+		*/
+		void registerPool(ComponentPoolBase &pool) {
+			pools.push_back(&pool);
+		}
+
+		/**
+		* move sprite and collider of an entity together
+		* @param entity entity to move
+		* @param dx movement in x
+		* @param dy movement in y
+		*/
+		void moveEntity(Entity entity, int dx, int dy) {
+			if (Sprite *sprite = sprites.find(entity)) {
+				sprite->rect.x += dx;
+				sprite->rect.y += dy;
+			}
+			if (Collider *collider = colliders.find(entity)) {
+				collider->rect.x += dx;
+				collider->rect.y += dy;
+			}
+		}
+
+	private:
+		friend void findCollisions(World &world, std::vector<CollisionPair> &pairs);
+
+		/**
+		* x range of a collider, used by findCollisions
+		*/
+		struct CollisionInterval {
+			int minX;
+			int maxX;
+			int slot;
+		};
+
+		std::vector<Uint32> generations;
+		std::vector<Uint32> freeIndices;
+		std::vector<ComponentPoolBase *> pools;
+		int aliveCount = 0;
+
+		/**
+		* buffer of findCollisions, kept to avoid allocation
+		*/
+		std::vector<CollisionInterval> intervals;
+	};
+
+	/**
+	* draw all sprites of a world in render screen
+	* @param world world which its sprites are drawn
+	*/
+	void drawSprites(World &world);
+
+	/**
+	* find all pairs of colliders of a world which have intersection
+	* colliders are sorted by x and swept once, so only nearby colliders are compared with each other
+	* @param world world which its colliders are checked
+	* @param pairs found pairs are written here, previous content is removed
+	*/
+	void findCollisions(World &world, std::vector<CollisionPair> &pairs);
+
+	/**
+	* find all entities of a world which their colliders have intersection with a rectangle
+	* @param world world which its colliders are checked
+	* @param rect rectangle to check with
+	* @param result found entities are written here, previous content is removed
+	*/
+	void findCollisions(World &world, const SDL_Rect &rect, std::vector<Entity> &result);
+
+	/**
+	* grid of tiles which agents walk on, used by NavGrid::findPath and FlowField
+	* tile (x, y) covers pixels from (x * tileSize, y * tileSize) to ((x + 1) * tileSize - 1, (y + 1) * tileSize - 1)
+	* agents move in 8 directions but can't cut corners of blocked tiles
+	* a straight step costs 10 and a diagonal step costs 14
+	*/
+	class NavGrid {
+	public:
+		/**
+		* create a grid without any blocked tile
+		* @param width number of tiles in x
+		* @param height number of tiles in y
+		* @param tileSize size of each tile in pixels
+		*/
+		NavGrid(int width, int height, int tileSize = 1);
+
+		/**
+		* number of tiles in x
+		*/
+		int getWidth() const {
+			return width;
+		}
+
+		/**
+		* number of tiles in y
+		*/
+		int getHeight() const {
+			return height;
+		}
+
+		/**
+		* size of each tile in pixels
+		*/
+		int getTileSize() const {
+			return tileSize;
+		}
+
+		/**
+		* @return true if tile can't be walked on, tiles outside of grid are blocked
+		*/
+		bool isBlocked(int x, int y) const {
+			return x < 0 || y < 0 || x >= width || y >= height || blocked[y * width + x];
+		}
+
+		/**
+		* block or unblock a tile
+		* @param x tile x
+		* @param y tile y
+		* @param block true to block tile
+		*/
+		void setBlocked(int x, int y, bool block);
+
+		/**
+		* block or unblock all tiles which have intersection with a rectangle in pixels
+		* @param area rectangle in pixels, for example position of a wall texture
+		* @param block true to block tiles
+		*/
+		void setBlocked(const SDL_Rect &area, bool block);
+
+		/**
+		* @return tile which contains a pixel, it may be outside of grid
+		*/
+		SDL_Point tileAt(int x, int y) const {
+			// round down for negative pixels too
+			SDL_Point tile = { x / tileSize - (x % tileSize < 0), y / tileSize - (y % tileSize < 0) };
+			return tile;
+		}
+
+		/**
+		* @return rectangle of a tile in pixels
+		*/
+		SDL_Rect tileRect(SDL_Point tile) const {
+			SDL_Rect rect = { tile.x * tileSize, tile.y * tileSize, tileSize, tileSize };
+			return rect;
+		}
+
+		/**
+		* find shortest path between two tiles with A* and jump point search
+		* path contains start, goal and tiles where path turns, tiles between two of them are in a straight or
+		diagonal line
+		* use it for a single agent, use FlowField when many agents go to same target
+		* @param start first tile
+		* @param goal last tile
+		* @param path found path is written here, previous content is removed
+		* @return false if goal can't be reached
+		*/
+		bool findPath(SDL_Point start, SDL_Point goal, std::vector<SDL_Point> &path);
+
+	private:
+		friend class FlowField;
+
+		/**
+		* follow a direction from (x, y) until a tile which path may turn at
+		* @return index of that tile or -1 if there is none
+		*/
+		int jump(int x, int y, int dx, int dy, int goalX, int goalY) const;
+
+		int width;
+		int height;
+		int tileSize;
+		std::vector<Uint8> blocked;
+
+		/**
+		* tiles which are changed, FlowField reads them to update itself
+		*/
+		std::vector<int> changes;
+
+		/**
+		* number of changes which are removed from beginning of changes
+		*/
+		Uint32 removedChanges = 0;
+
+		/**
+		* state of findPath, a tile belongs to current search only if its stamp is equal to searchId
+		*/
+		std::vector<int> pathCost;
+		std::vector<int> pathParent;
+		std::vector<Uint32> openStamp;
+		std::vector<Uint32> closedStamp;
+		std::vector<std::pair<int, int> > openList;
+		Uint32 searchId = 0;
+	};
+
+	/**
+	* direction to a shared target from every tile of a NavGrid
+	* computing it costs about as much as one path search over whole grid, after that every agent finds its way
+	in constant time, so it is much cheaper than findPath when many agents go to same target
+	* when tiles of grid change, only affected part of the field is computed again
+	*/
+	class FlowField {
+	public:
+		/**
+		* create a field without target
+		* @param grid grid which field is computed on, it must live longer than field
+		*/
+		explicit FlowField(const NavGrid &grid);
+
+		/**
+		* change target of all agents, whole field is computed again
+		* @param tile target tile
+		*/
+		void setTarget(SDL_Point tile);
+
+		/**
+		* @return target tile
+		*/
+		SDL_Point getTarget() const {
+			return target;
+		}
+
+		/**
+		* apply changed tiles of grid to field, call it once per frame before using field
+		*/
+		void update();
+
+		/**
+		* direction of next step from a tile toward target, each component is -1, 0 or 1
+		* @return (0, 0) if tile is target or target can't be reached
+		*/
+		SDL_Point direction(SDL_Point tile) const;
+
+		/**
+		* cost of shortest path from a tile to target (straight step 10, diagonal step 14)
+		* @return -1 if target can't be reached
+		*/
+		int distance(SDL_Point tile) const;
+
+	private:
+		/**
+		* compute whole field again
+		*/
+		void rebuild();
+
+		/**
+		* spread distances from tiles in heap to their neighbors
+		*/
+		void propagate();
+
+		/**
+		* add a tile to heap
+		*/
+		void push(int distance, int index);
+
+		const NavGrid &grid;
+		SDL_Point target;
+
+		/**
+		* number of grid changes which are applied to field
+		*/
+		Uint32 appliedChanges = 0;
+
+		/**
+		* cost to target and direction of next step (0-7, or 255 for none) of each tile
+		*/
+		std::vector<int> distances;
+		std::vector<Uint8> next;
+
+		/**
+		* buffers of update, kept to avoid allocation
+		*/
+		std::vector<std::pair<int, int> > heap;
+		std::vector<Uint8> invalid;
+		std::vector<int> invalidTiles;
+	};
 }
+
+#endif // SBDL_H